@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <time.h>
+
+namespace pwswd::benchmark {
+
+    [[nodiscard]] inline std::uint64_t getNanoSeconds() {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+
+        return std::uint64_t(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+    }
+
+    // Prints a single result, one "name value" pair per line like the daemon's own statistics
+    template<typename T>
+    void report(const std::string &name, T value) {
+        std::cout << name << " " << value << std::endl;
+    }
+
+    /**
+     * Runs the callback in batches until MinDuration passed and reports the mean time per call as
+     * <name>_ns_per_op together with the number of calls. The first batch only warms up caches
+     * and lazily built state and isn't counted. Returns the mean time per call in nanoseconds.
+     */
+    template<typename Callback>
+    std::uint64_t run(const std::string &name, Callback callback) {
+        constexpr std::uint64_t MinDuration = 500'000'000;
+        constexpr std::uint32_t BatchSize = 64;
+
+        for (std::uint32_t i = 0; i < BatchSize; i++)
+            callback();
+
+        std::uint64_t iterations = 0;
+        const auto startTime = getNanoSeconds();
+        std::uint64_t elapsed = 0;
+
+        do {
+            for (std::uint32_t i = 0; i < BatchSize; i++)
+                callback();
+
+            iterations += BatchSize;
+            elapsed = getNanoSeconds() - startTime;
+        } while (elapsed < MinDuration);
+
+        report(name + "_ns_per_op", elapsed / iterations);
+        report(name + "_iterations", iterations);
+
+        return elapsed / iterations;
+    }
+
+}
\ No newline at end of file
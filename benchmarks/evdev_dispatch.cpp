@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <string>
+
+#include "benchmark.hpp"
+#include "stick_calibrator.hpp"
+#include "devices/event_poller.hpp"
+#include "devices/fake_event_device.hpp"
+#include "devices/fake_sysfs.hpp"
+#include "devices/screen.hpp"
+
+// Reads batches of frames from pipe backed devices and hands them to the same consumers the daemon uses
+int main() {
+    constexpr std::uint32_t FramesPerWakeup = 8;
+
+    // Joystick frames only feed the calibrator when mouse mode is off, which is how they arrive most of the time
+    {
+        pwswd::dev::FakeEventDevice fakeJoystick;
+        pwswd::dev::EventPoller joystickEvent(fakeJoystick.getPath());
+        pwswd::StickCalibrator stickCalibrator("/dev/null");
+
+        std::int32_t offset = 0;
+        pwswd::benchmark::run("evdev_joystick_wakeup", [&] {
+            for (std::uint32_t i = 0; i < FramesPerWakeup; i++, offset = (offset + 7) % 32) {
+                fakeJoystick.injectFrame({
+                    pwswd::createAbsoluteAxisInputEvent(pwswd::RelativeAxis::AxisX, pwswd::JoyStickXAxisCenter + offset),
+                    pwswd::createAbsoluteAxisInputEvent(pwswd::RelativeAxis::AxisY, pwswd::JoyStickYAxisCenter - offset)
+                });
+            }
+
+            joystickEvent.readFrames([&](const pwswd::InputFrame &frame) {
+                for (const auto &eventData : frame)
+                    stickCalibrator.update(eventData.code, eventData.value, pwswd::toMicroSeconds(eventData.time));
+            });
+        });
+    }
+
+    // Key repeats of a brightness shortcut, staged while dispatching and written to the fake sysfs once per wakeup
+    {
+        pwswd::dev::FakeSysfs fakeSysfs;
+        fakeSysfs.addAttribute("/class/graphics/fb0/blank", "0");
+        fakeSysfs.addAttribute("/devices/platform/jz-lcd.0/sharpness_upscaling", "8");
+        fakeSysfs.addAttribute("/devices/platform/jz-lcd.0/sharpness_downscaling", "8");
+        fakeSysfs.addAttribute("/devices/platform/jz-lcd.0/keep_aspect_ratio", "N");
+        fakeSysfs.addAttribute("/devices/platform/pwm-backlight/backlight/pwm-backlight/brightness", "100");
+
+        pwswd::dev::FakeEventDevice fakeButtons;
+        pwswd::dev::EventPoller buttonEvent(fakeButtons.getPath());
+        pwswd::dev::Screen screen(fakeSysfs.getRoot());
+
+        bool increase = true;
+        pwswd::benchmark::run("evdev_button_shortcut_wakeup", [&] {
+            const auto button = increase ? pwswd::Button::DpadUp : pwswd::Button::DpadDown;
+            increase = !increase;
+
+            for (std::uint32_t i = 0; i < FramesPerWakeup; i++)
+                fakeButtons.injectFrame({ pwswd::createButtonInputEvent(button, pwswd::ButtonState::Pressed) });
+
+            buttonEvent.readFrames([&](const pwswd::InputFrame &frame) {
+                for (const auto &eventData : frame) {
+                    if (eventData.code == static_cast<std::uint16_t>(pwswd::Button::DpadUp))
+                        screen.increaseBrightness();
+                    else if (eventData.code == static_cast<std::uint16_t>(pwswd::Button::DpadDown))
+                        screen.decreaseBrightness();
+                }
+            });
+
+            screen.flush();
+        });
+    }
+
+    pwswd::benchmark::report("evdev_frames_per_wakeup", FramesPerWakeup);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "devices/fake_framebuffer.hpp"
+#include "gfx/span_fill.hpp"
+
+// The loop fillRect used before the span kernels: columns on the outside and a memcpy of runtime size per pixel
+__attribute__((noinline)) void fillRectPerPixel(std::uint8_t *dst, std::size_t pitch, std::uint32_t width, std::uint32_t height, std::uint8_t bpp, std::uint32_t color) {
+    for (std::uint32_t x = 0; x < width; x++)
+        for (std::uint32_t y = 0; y < height; y++)
+            std::memcpy(&dst[y * pitch + x * bpp], &color, bpp);
+}
+
+template<std::uint8_t BytesPerPixel>
+void compareWithPerPixelLoop(std::uint32_t width, std::uint32_t height) {
+    const std::size_t pitch = std::size_t(width) * BytesPerPixel;
+    std::vector<std::uint8_t> page(pitch * height);
+
+    // Read through a volatile so the baseline can't be specialized for the pixel size either
+    volatile std::uint8_t runtimeBpp = BytesPerPixel;
+
+    const std::string prefix = "framebuffer_fill_" + std::to_string(BytesPerPixel * 8) + "bpp_" + std::to_string(width) + "x" + std::to_string(height) + "_";
+
+    const auto perPixelTime = pwswd::benchmark::run(prefix + "per_pixel", [&] {
+        fillRectPerPixel(page.data(), pitch, width, height, runtimeBpp, 0x5A5A5A5A);
+    });
+
+    const auto spanTime = pwswd::benchmark::run(prefix + "span", [&] {
+        pwswd::gfx::fillRect<BytesPerPixel>(page.data(), pitch, width, height, 0x5A5A5A5A);
+    });
+
+    pwswd::benchmark::report(prefix + "speedup_x100", spanTime > 0 ? perPixelTime * 100 / spanTime : 0);
+}
+
+// Fills rects of the sizes overlays use, opaque and translucent, in both pixel formats the panels use
+int main() {
+    for (std::uint32_t bitsPerPixel : { 16, 32 }) {
+        pwswd::dev::FakeFramebuffer fakeFramebuffer(320, 240, bitsPerPixel);
+        auto &framebuffer = fakeFramebuffer.get();
+
+        const std::string prefix = "framebuffer_fill_" + std::to_string(bitsPerPixel) + "bpp_";
+        const pwswd::dev::Rect overlayRect = { 40, 180, 240, 40 };
+        const pwswd::dev::Rect screenRect = { 0, 0, 320, 240 };
+
+        pwswd::benchmark::run(prefix + "overlay_opaque", [&] {
+            framebuffer.fillRect(overlayRect, 0x202020FF);
+        });
+
+        pwswd::benchmark::run(prefix + "overlay_translucent", [&] {
+            framebuffer.fillRect(overlayRect, 0x202020C0);
+        });
+
+        pwswd::benchmark::run(prefix + "screen_opaque", [&] {
+            framebuffer.fillRect(screenRect, 0x505050FF);
+        });
+
+        pwswd::benchmark::report(prefix + "overlay_pixels", overlayRect.w * overlayRect.h);
+    }
+
+    // Whole 640x480 screens, the old per-pixel loop against the span kernels
+    compareWithPerPixelLoop<2>(640, 480);
+    compareWithPerPixelLoop<4>(640, 480);
+}
\ No newline at end of file
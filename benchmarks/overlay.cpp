@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <string>
+
+#include "benchmark.hpp"
+#include "devices/fake_framebuffer.hpp"
+#include "overlay_manager.hpp"
+
+// Renders overlays the way the frame timer does, once with the sprite cached and once with a new value every frame
+int main() {
+    constexpr std::uint32_t Timeout = 60'000;
+
+    for (std::uint32_t bitsPerPixel : { 16, 32 }) {
+        pwswd::dev::FakeFramebuffer fakeFramebuffer(320, 240, bitsPerPixel);
+        pwswd::OverlayManager overlayManager;
+        overlayManager.initialize(std::addressof(fakeFramebuffer.get()), nullptr);
+
+        const std::string prefix = "overlay_" + std::to_string(bitsPerPixel) + "bpp_";
+
+        pwswd::benchmark::run(prefix + "slider_cached", [&] {
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::VolumeSlider, 50, Timeout });
+            overlayManager.render();
+        });
+
+        // Cycles through more slider values than the sprite cache holds, so most frames draw their sprite from scratch
+        std::uint32_t value = 0;
+        pwswd::benchmark::run(prefix + "slider_changing", [&] {
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::BrightnessSlider, value, Timeout });
+            overlayManager.render();
+            value = (value + 1) % 101;
+        });
+
+        pwswd::benchmark::run(prefix + "popup_cached", [&] {
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::MutePopup, 0, Timeout });
+            overlayManager.render();
+        });
+
+        // Page flips of the application invalidate the backups, every frame has to draw to a new page
+        std::uint8_t page = 0;
+        pwswd::benchmark::run(prefix + "slider_page_flip", [&] {
+            page = (page + 1) % pwswd::dev::Framebuffer::NumFramebuffers;
+            fakeFramebuffer.flip(page);
+
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::VolumeSlider, 50, Timeout });
+            overlayManager.render();
+        });
+    }
+}
\ No newline at end of file
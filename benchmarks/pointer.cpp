@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "benchmark.hpp"
+#include "event_loop.hpp"
+#include "pointer_engine.hpp"
+#include "devices/uinput.hpp"
+
+// Creates the same virtual mouse as the daemon, or writes to /dev/null if uinput isn't available
+std::unique_ptr<pwswd::dev::UInput> createMouse(bool &real) {
+    try {
+        auto mouse = std::make_unique<pwswd::dev::UInput>("/dev/uinput", "pwswdpp benchmark mouse", pwswd::dev::InputId { 0x03, 1, 1, 1 });
+
+        mouse->setEventFilterBit(pwswd::EventType::Buttons);
+        mouse->setEventFilterBit(pwswd::EventType::RelativeAxes);
+        mouse->setKeyFilterBit(pwswd::Button::MouseLeft);
+        mouse->setKeyFilterBit(pwswd::Button::MouseRight);
+        mouse->setRelativeFilterBit(pwswd::RelativeAxis::AxisX);
+        mouse->setRelativeFilterBit(pwswd::RelativeAxis::AxisY);
+        mouse->createDevice();
+
+        real = true;
+        return mouse;
+    } catch (const std::runtime_error &) {
+        real = false;
+        return std::make_unique<pwswd::dev::UInput>("/dev/null", "pwswdpp benchmark mouse", pwswd::dev::InputId { 0x03, 1, 1, 1 });
+    }
+}
+
+// Runs the pointer engine the way the joystick and the tick timer do, without waiting for the timer to actually expire
+int main() {
+    pwswd::Timer pointerTimer;
+    pwswd::PointerEngine pointerEngine;
+    pointerEngine.initialize(std::addressof(pointerTimer));
+
+    bool realUInput = false;
+    auto mouse = createMouse(realUInput);
+
+    std::int32_t displacement = 0;
+    pwswd::benchmark::run("pointer_set_displacement", [&] {
+        displacement = (displacement + 37) % 1600;
+        pointerEngine.setDisplacement(displacement + 1, -displacement - 1);
+    });
+
+    pointerEngine.setDisplacement(800, 400);
+    pwswd::benchmark::run("pointer_tick_inject", [&] {
+        auto [deltaX, deltaY] = pointerEngine.tick();
+
+        mouse->queue(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisX, deltaX));
+        mouse->queue(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisY, deltaY));
+        mouse->flush();
+    });
+
+    pointerEngine.stop();
+
+    pwswd::benchmark::report("pointer_real_uinput", realUInput);
+}
\ No newline at end of file
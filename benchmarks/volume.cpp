@@ -0,0 +1,36 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "benchmark.hpp"
+#include "devices/audio.hpp"
+#include "devices/mixer.hpp"
+
+// Runs the volume step logic the shortcuts go through against in-memory elements, without the ioctls of the real control device
+int main() {
+    // A fine element like the handheld's PCM control and one coarser than the step, which takes the rounding fallback
+    for (long maximum : { 255L, 3L }) {
+        auto mixer = std::make_unique<pwswd::dev::MockMixer>(0, maximum);
+        auto mock = mixer.get();
+        pwswd::dev::Audio audio(std::move(mixer));
+
+        const std::string prefix = "volume_" + std::to_string(maximum + 1) + "_steps_";
+
+        // Walks up and down the whole range so clamped steps at either end are part of the mix
+        bool rising = true;
+        pwswd::benchmark::run(prefix + "change", [&] {
+            const auto volume = audio.getVolume().value_or(0);
+            if (volume == 100)
+                rising = false;
+            else if (volume == 0)
+                rising = true;
+
+            if (rising)
+                audio.increase(5);
+            else
+                audio.decrease(5);
+        });
+
+        pwswd::benchmark::report(prefix + "writes", mock->getWriteCount());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+
+namespace pwswd {
+
+    /**
+     * Fixed capacity queue that any number of threads may push to and one thread pops from,
+     * without locks or allocations. Every cell carries a sequence number telling whether it's
+     * free for the producer at that position or holds a value for the consumer.
+     */
+    template<typename T, std::size_t Capacity>
+    class BoundedQueue {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity needs to be a power of two");
+
+    public:
+        BoundedQueue() {
+            for (std::size_t i = 0; i < Capacity; i++)
+                this->m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        // Returns false if the queue is full
+        bool push(const T &value) {
+            std::size_t position = this->m_pushPosition.load(std::memory_order_relaxed);
+
+            while (true) {
+                auto &cell = this->m_cells[position & (Capacity - 1)];
+                const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = std::intptr_t(sequence) - std::intptr_t(position);
+
+                if (difference == 0) {
+                    // Claim the cell, another producer may have been faster
+                    if (this->m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = this->m_pushPosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Only ever called from the consuming thread
+        std::optional<T> pop() {
+            auto &cell = this->m_cells[this->m_popPosition & (Capacity - 1)];
+
+            if (cell.sequence.load(std::memory_order_acquire) != this->m_popPosition + 1)
+                return std::nullopt;
+
+            T value = cell.value;
+            cell.sequence.store(this->m_popPosition + Capacity, std::memory_order_release);
+            this->m_popPosition++;
+
+            return value;
+        }
+
+        // Only ever called from the consuming thread
+        [[nodiscard]] bool empty() const {
+            return this->m_cells[this->m_popPosition & (Capacity - 1)].sequence.load(std::memory_order_acquire) != this->m_popPosition + 1;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::array<Cell, Capacity> m_cells;
+        std::atomic<std::size_t> m_pushPosition = 0;
+        std::size_t m_popPosition = 0;
+    };
+
+}
\ No newline at end of file
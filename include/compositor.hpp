@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "devices/framebuffer.hpp"
+#include "gfx/surface.hpp"
+
+namespace pwswd {
+
+    /**
+     * Keeps a copy of the game's pixels underneath every rect an overlay draws to, so they
+     * can be put back once the overlay disappears or moves. Only rects that changed between
+     * two frames are saved or restored, everything else stays untouched.
+     *
+     * What the overlay drew is remembered as well. Pixels that don't match it anymore were
+     * redrawn by the game, refreshBackup() picks those up so translucent overlays blend over
+     * the game's current frame instead of the one they first appeared on.
+     */
+    class Compositor {
+    public:
+        Compositor() : m_framebuffer(nullptr) { }
+
+        void initialize(pwswd::dev::Framebuffer *framebuffer) {
+            this->m_framebuffer = framebuffer;
+        }
+
+        /**
+         * Declares the rects the next frame is going to draw to. Rects of the previous frame
+         * that aren't part of it anymore get restored, new ones get backed up.
+         */
+        void prepare(const std::vector<pwswd::dev::Rect> &rects) {
+            // The game flipped to another page since the last frame. The page the overlay was drawn on is its back
+            // buffer now and gets redrawn by the game, writing backups into it would race with that. Drop them and
+            // start over on the visible one, the overlay will be redrawn there
+            if (this->m_framebuffer->getVisiblePageOffset() != this->m_pageOffset) {
+                this->discard();
+                this->m_pageOffset = this->m_framebuffer->getVisiblePageOffset();
+            }
+
+            // Backups of another mode have the wrong size and pixel format, the game redraws the whole screen after a mode change anyway
+            if (this->m_framebuffer->getLayoutVersion() != this->m_layoutVersion) {
+                this->discard();
+                this->m_layoutVersion = this->m_framebuffer->getLayoutVersion();
+            }
+
+            // Restore stale rects first so new backups never contain old overlay pixels. Go backwards in case they overlap
+            for (auto savedRect = this->m_savedRects.rbegin(); savedRect != this->m_savedRects.rend(); savedRect++) {
+                if (!contains(rects, savedRect->rect))
+                    this->m_framebuffer->restoreRect(savedRect->rect, &this->m_backingStore[savedRect->offset], this->m_pageOffset);
+            }
+
+            // Keep the backups that are still valid and pack them to the front of the backing store
+            std::size_t usedSize = 0;
+            auto &savedRects = this->m_nextSavedRects;
+            savedRects.clear();
+
+            for (const auto &savedRect : this->m_savedRects) {
+                if (!contains(rects, savedRect.rect))
+                    continue;
+
+                auto size = this->m_framebuffer->getRectSize(savedRect.rect);
+                std::memmove(&this->m_backingStore[usedSize], &this->m_backingStore[savedRect.offset], size);
+                if (savedRect.drawn)
+                    std::memmove(&this->m_drawnStore[usedSize], &this->m_drawnStore[savedRect.offset], size);
+                savedRects.push_back({ savedRect.rect, usedSize, savedRect.drawn });
+                usedSize += size;
+            }
+
+            // Back up the pixels underneath all new rects
+            for (const auto &rect : rects) {
+                if (rect.empty() || containsSaved(savedRects, rect))
+                    continue;
+
+                auto size = this->m_framebuffer->getRectSize(rect);
+
+                // The backing store only ever grows, so once it fits the largest overlay it's never reallocated again
+                if (this->m_backingStore.size() < usedSize + size) {
+                    this->m_backingStore.resize(usedSize + size);
+                    this->m_drawnStore.resize(usedSize + size);
+                }
+
+                this->m_framebuffer->saveRect(rect, &this->m_backingStore[usedSize], this->m_pageOffset);
+                savedRects.push_back({ rect, usedSize, false });
+                usedSize += size;
+            }
+
+            std::swap(this->m_savedRects, this->m_nextSavedRects);
+        }
+
+        // Puts back everything that was drawn over, on the page it was drawn to
+        void restore() {
+            // The pixels would land in the wrong place after a mode change
+            if (this->m_framebuffer->getLayoutVersion() != this->m_layoutVersion)
+                this->discard();
+
+            for (auto savedRect = this->m_savedRects.rbegin(); savedRect != this->m_savedRects.rend(); savedRect++)
+                this->m_framebuffer->restoreRect(savedRect->rect, &this->m_backingStore[savedRect->offset], this->m_pageOffset);
+
+            this->m_savedRects.clear();
+        }
+
+        // Forgets all backups without writing them back, e.g. when the screen layout changed underneath
+        void discard() {
+            this->m_savedRects.clear();
+        }
+
+        // Remembers what the overlay drew into a rect of the current frame, call once it's done drawing
+        void commit(const pwswd::dev::Rect &rect) {
+            for (auto &savedRect : this->m_savedRects) {
+                if (savedRect.rect == rect) {
+                    this->m_framebuffer->saveRect(rect, &this->m_drawnStore[savedRect.offset], this->m_pageOffset);
+                    savedRect.drawn = true;
+                }
+            }
+        }
+
+        /**
+         * Takes over every pixel of the rect the game drew to since the last commit into the backup and
+         * returns it. Pixels the game didn't touch still show the overlay, their backup stays as it is.
+         */
+        [[nodiscard]] pwswd::gfx::Surface refreshBackup(const pwswd::dev::Rect &rect) {
+            auto backup = this->getBackup(rect);
+
+            for (const auto &savedRect : this->m_savedRects) {
+                if (savedRect.rect != rect || !savedRect.drawn)
+                    continue;
+
+                const std::uint8_t bpp = backup.bytesPerPixel;
+                const std::uint8_t *drawn = &this->m_drawnStore[savedRect.offset];
+                auto page = this->m_framebuffer->getVisibleSurface().getSubSurface(rect.x, rect.y, rect.w, rect.h);
+
+                for (std::uint32_t y = 0; y < page.height; y++) {
+                    const std::uint8_t *pageRow = page.data + y * page.pitch;
+                    const std::uint8_t *drawnRow = drawn + y * backup.pitch;
+                    std::uint8_t *backupRow = backup.data + y * backup.pitch;
+
+                    // Most of the time the game either redrew the whole row or none of it
+                    if (std::memcmp(pageRow, drawnRow, std::size_t(page.width) * bpp) == 0)
+                        continue;
+
+                    for (std::size_t x = 0; x < std::size_t(page.width) * bpp; x += bpp) {
+                        if (std::memcmp(&pageRow[x], &drawnRow[x], bpp) != 0)
+                            std::memcpy(&backupRow[x], &pageRow[x], bpp);
+                    }
+                }
+            }
+
+            return backup;
+        }
+
+        // The game's pixels underneath a rect of the current frame, empty if the rect hasn't been backed up
+        [[nodiscard]] pwswd::gfx::Surface getBackup(const pwswd::dev::Rect &rect) {
+            const std::uint8_t bpp = this->m_framebuffer->getStride();
+
+            for (const auto &savedRect : this->m_savedRects) {
+                if (savedRect.rect == rect)
+                    return { &this->m_backingStore[savedRect.offset], std::size_t(rect.w) * bpp, rect.w, rect.h, bpp };
+            }
+
+            return { nullptr, 0, 0, 0, bpp };
+        }
+
+        // Writes the game's pixels back into a copy of the visible page, so it doesn't show any overlays
+        void restoreInto(const pwswd::gfx::Surface &page) {
+            // The backups belong to a page that isn't visible anymore or to another mode
+            if (this->m_framebuffer->getVisiblePageOffset() != this->m_pageOffset || this->m_framebuffer->getLayoutVersion() != this->m_layoutVersion)
+                return;
+
+            for (auto savedRect = this->m_savedRects.rbegin(); savedRect != this->m_savedRects.rend(); savedRect++) {
+                auto backup = this->getBackup(savedRect->rect);
+                pwswd::gfx::blit(page.getSubSurface(savedRect->rect.x, savedRect->rect.y, savedRect->rect.w, savedRect->rect.h), backup);
+            }
+        }
+
+        [[nodiscard]] bool isDirty() const {
+            return !this->m_savedRects.empty();
+        }
+
+    private:
+        struct SavedRect {
+            pwswd::dev::Rect rect;
+            std::size_t offset;
+            bool drawn;
+        };
+
+        pwswd::dev::Framebuffer *m_framebuffer;
+        std::size_t m_pageOffset = 0;
+        std::uint32_t m_layoutVersion = 0;
+
+        // What the overlay last drew into each rect, laid out like the backing store
+        std::vector<std::uint8_t> m_backingStore, m_drawnStore;
+        std::vector<SavedRect> m_savedRects, m_nextSavedRects;
+
+        static bool contains(const std::vector<pwswd::dev::Rect> &rects, const pwswd::dev::Rect &rect) {
+            for (const auto &other : rects)
+                if (other == rect)
+                    return true;
+
+            return false;
+        }
+
+        static bool containsSaved(const std::vector<SavedRect> &savedRects, const pwswd::dev::Rect &rect) {
+            for (const auto &savedRect : savedRects)
+                if (savedRect.rect == rect)
+                    return true;
+
+            return false;
+        }
+    };
+
+}
\ No newline at end of file
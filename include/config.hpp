@@ -0,0 +1,119 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "devices/screen.hpp"
+#include "events.hpp"
+#include "shortcut_table.hpp"
+
+namespace pwswd {
+
+    /**
+     * Everything that can be tuned without rebuilding the daemon. The file has one setting per line,
+     * like "volume_step 5" or "brightness_steps 8 16 32 64 128 255", shortcut bindings start with
+     * their layer. Anything after a # is a comment, settings missing from the file keep their defaults.
+     */
+    struct Config {
+        ShortcutTable shortcuts = DefaultShortcuts;
+
+        // In microseconds, like the timestamps of input events
+        std::uint64_t powerButtonShortPressDuration = PowerButtonShortPressDuration;
+        std::uint64_t powerButtonLongPressDuration = PowerButtonLongPressDuration;
+
+        std::int32_t joystickDeadZone = JoyStickDeadZone;
+        std::vector<std::uint8_t> brightnessValues { dev::Screen::DefaultBrightnessValues.begin(), dev::Screen::DefaultBrightnessValues.end() };
+        std::uint8_t volumeStep = 5;
+        std::uint32_t overlayTimeout = 1500;
+
+        // Defaults with the settings of the file applied on top, broken lines are reported and skipped
+        [[nodiscard]] static Config load(const std::string &path) {
+            Config config;
+
+            std::ifstream file(path);
+            std::string line;
+
+            for (std::uint32_t lineNumber = 1; std::getline(file, line); lineNumber++) {
+                line = line.substr(0, line.find('#'));
+
+                std::istringstream stream(line);
+                std::string key;
+                if (!(stream >> key))
+                    continue;
+
+                std::vector<std::string> values;
+                for (std::string value; stream >> value;)
+                    values.push_back(std::move(value));
+
+                if (!config.set(key, values))
+                    std::cerr << path << ":" << lineNumber << ": Invalid setting \"" << line << "\"" << std::endl;
+            }
+
+            return config;
+        }
+
+    private:
+        // Half of the stick's travel, a larger dead zone would swallow all movement
+        static constexpr std::uint32_t MaxJoystickDeadZone = 1000;
+
+        [[nodiscard]] bool set(std::string_view key, const std::vector<std::string> &values) {
+            if (key == "plain" || key == "power")
+                return values.size() == 2 && this->shortcuts.bind(key, values[0], values[1]);
+
+            if (key == "brightness_steps")
+                return setBrightnessValues(values);
+
+            std::uint32_t value;
+            if (values.size() != 1 || !parseNumber(values[0], value))
+                return false;
+
+            if (key == "power_short_press_ms" && value > 0)
+                this->powerButtonShortPressDuration = value * 1000ULL;
+            else if (key == "power_long_press_ms" && value > 0)
+                this->powerButtonLongPressDuration = value * 1000ULL;
+            else if (key == "joystick_dead_zone" && value <= MaxJoystickDeadZone)
+                this->joystickDeadZone = value;
+            else if (key == "volume_step" && value > 0 && value <= 100)
+                this->volumeStep = value;
+            else if (key == "overlay_timeout_ms" && value > 0)
+                this->overlayTimeout = value;
+            else
+                return false;
+
+            return true;
+        }
+
+        // Steps have to get brighter one after the other, otherwise the brightness slider would jump around
+        [[nodiscard]] bool setBrightnessValues(const std::vector<std::string> &values) {
+            std::vector<std::uint8_t> brightnessValues;
+
+            for (const auto &string : values) {
+                std::uint32_t value;
+                if (!parseNumber(string, value) || value == 0 || value > 0xFF || (!brightnessValues.empty() && value <= brightnessValues.back()))
+                    return false;
+
+                brightnessValues.push_back(value);
+            }
+
+            if (brightnessValues.size() < 2)
+                return false;
+
+            this->brightnessValues = std::move(brightnessValues);
+            return true;
+        }
+
+        [[nodiscard]] static bool parseNumber(std::string_view string, std::uint32_t &value) {
+            const auto end = string.data() + string.size();
+            const auto [ptr, error] = std::from_chars(string.data(), end, value);
+
+            return error == std::errc() && ptr == end;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "config.hpp"
+#include "event_loop.hpp"
+
+namespace pwswd {
+
+    /**
+     * Keeps the current config and picks up changes to its file while the daemon is running.
+     * The file's directory is watched with inotify, so editors that replace the file instead of
+     * writing it in place get noticed as well and the file doesn't have to exist yet.
+     *
+     * Files get parsed on a worker thread which publishes the new config with a single pointer
+     * swap, the event loop never waits for a reload. Replaced configs are only freed once the
+     * event loop got to the reload notification, so references taken through get() stay valid
+     * until the callback that took them returns. Don't hold on to them any longer than that.
+     */
+    class ConfigManager {
+    public:
+        ConfigManager() {
+            this->m_inotifyfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+            if (this->m_inotifyfd == -1)
+                throw std::runtime_error("Failed to create inotify instance!");
+        }
+
+        ~ConfigManager() {
+            {
+                std::scoped_lock lock(this->m_lock);
+                this->m_running = false;
+            }
+
+            this->m_condition.notify_one();
+
+            if (this->m_worker.joinable())
+                this->m_worker.join();
+
+            for (auto config : this->m_retired)
+                delete config;
+            delete this->m_current.load();
+
+            close(this->m_inotifyfd);
+        }
+
+        ConfigManager(const ConfigManager&) = delete;
+        ConfigManager& operator=(const ConfigManager&) = delete;
+
+        // Loads the file right away so everything starts out with the right settings
+        void initialize(const std::string &path) {
+            const auto slash = path.rfind('/');
+            const std::string directory = slash == std::string::npos ? "." : path.substr(0, std::max<std::size_t>(slash, 1));
+
+            this->m_path = path;
+            this->m_fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+            this->m_current = new Config(Config::load(path));
+
+            // Not being able to watch the directory only costs live reloading
+            if (inotify_add_watch(this->m_inotifyfd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1)
+                std::cerr << "Failed to watch " << directory << " for config changes" << std::endl;
+
+            this->m_running = true;
+            this->m_worker = std::thread([this] { this->processReloads(); });
+        }
+
+        [[nodiscard]] const Config& get() const {
+            return *this->m_current.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] int getWatchFd() const {
+            return this->m_inotifyfd;
+        }
+
+        [[nodiscard]] int getReloadFd() const {
+            return this->m_reloadNotifier.getFd();
+        }
+
+        // Drains the inotify fd and hands the file to the worker if it changed. Returns the number of inotify events read
+        std::uint32_t handleFileEvents() {
+            alignas(inotify_event) char buffer[4096];
+            std::uint32_t count = 0;
+            bool changed = false;
+
+            ssize_t size;
+            while ((size = read(this->m_inotifyfd, buffer, sizeof(buffer))) > 0) {
+                for (ssize_t offset = 0; offset < size;) {
+                    const auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+                    if (event->len > 0 && this->m_fileName == event->name)
+                        changed = true;
+
+                    offset += sizeof(inotify_event) + event->len;
+                    count++;
+                }
+            }
+
+            if (changed) {
+                {
+                    std::scoped_lock lock(this->m_lock);
+                    this->m_pending = true;
+                }
+
+                this->m_condition.notify_one();
+            }
+
+            return count;
+        }
+
+        /**
+         * Frees the configs the worker replaced. Has to be called from the event loop after a reload got
+         * signaled through the reload fd, by then nothing can still be using them. Returns true if the
+         * config changed since the last call.
+         */
+        bool reclaim() {
+            if (this->m_reloadNotifier.acknowledge() == 0)
+                return false;
+
+            std::vector<const Config*> retired;
+            {
+                std::scoped_lock lock(this->m_lock);
+                retired.swap(this->m_retired);
+            }
+
+            for (auto config : retired)
+                delete config;
+
+            return true;
+        }
+
+        [[nodiscard]] std::uint64_t getReloadCount() const {
+            return this->m_reloadCount;
+        }
+
+    private:
+        int m_inotifyfd;
+        std::string m_path, m_fileName;
+
+        std::atomic<const Config*> m_current = nullptr;
+        std::vector<const Config*> m_retired;
+        std::atomic<std::uint64_t> m_reloadCount = 0;
+        Notifier m_reloadNotifier;
+
+        std::thread m_worker;
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        bool m_running = false, m_pending = false;
+
+        void processReloads() {
+            // Signals belong to the event loop, even if the thread got started before main() blocked them
+            sigset_t signals;
+            sigfillset(&signals);
+            pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+            std::unique_lock lock(this->m_lock);
+
+            while (true) {
+                this->m_condition.wait(lock, [this] { return this->m_pending || !this->m_running; });
+                if (!this->m_running)
+                    break;
+
+                this->m_pending = false;
+                lock.unlock();
+
+                const auto config = new Config(Config::load(this->m_path));
+                const auto previous = this->m_current.exchange(config, std::memory_order_acq_rel);
+                this->m_reloadCount++;
+
+                lock.lock();
+                this->m_retired.push_back(previous);
+
+                this->m_reloadNotifier.notify();
+            }
+        }
+    };
+
+}
\ No newline at end of file
@@ -1,56 +1,49 @@
 #pragma once 
 
 #include <cstdint>
-#include <unistd.h>
-#include <fcntl.h>
-#include <cstdio>
-#include <sys/wait.h>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "mixer.hpp"
 
 namespace pwswd::dev {
 
     class Audio {
     public:
-        Audio() { }
+        explicit Audio(const std::string &controlDevicePath = ControlDevicePath) {
+            // Prefer talking to the mixer directly, only spawn amixer if the control device isn't usable
+            try {
+                this->m_mixer = std::make_unique<AlsaMixer>(controlDevicePath, ControlElementName);
+            } catch (const std::runtime_error &) {
+                this->m_mixer = std::make_unique<AmixerMixer>(SimpleElementName);
+            }
+        }
+
+        Audio(std::unique_ptr<MixerBackend> &&mixer) : m_mixer(std::move(mixer)) { }
         
         void mute() {
-            pid_t child = fork();
-
-            if (!child)
-                execlp("amixer", "-M", "-q", "set", "PCM", "0%", nullptr);
-
-            int status = 0;
-            waitpid(child, &status, 0);
+            this->m_mixer->setVolume(0);
         }
 
         void increase(std::uint8_t step = 5) {
-            char percentage[7];
-
-            snprintf(percentage, 6, "%u%%+", step);
-
-            pid_t child = fork();
-
-            if (!child)
-                execlp("amixer", "-M", "-q", "set", "PCM", percentage, nullptr);
-
-            int status = 0;
-            waitpid(child, &status, 0);
+            this->m_mixer->changeVolume(step);
         }
 
         void decrease(std::uint8_t step = 5) {
-            char percentage[7];
-
-            snprintf(percentage, 6, "%u%%-", step);
-
-            pid_t child = fork();
-
-            if (!child)
-                execlp("amixer", "-M", "-q", "set", "PCM", percentage, nullptr);
+            this->m_mixer->changeVolume(-step);
+        }
 
-            int status = 0;
-            waitpid(child, &status, 0);
+        [[nodiscard]] std::optional<std::uint8_t> getVolume() {
+            return this->m_mixer->getVolume();
         }
 
     private:
+        static constexpr auto ControlDevicePath = "/dev/snd/controlC0";
+        static constexpr auto ControlElementName = "PCM Playback Volume";
+        static constexpr auto SimpleElementName = "PCM";
+
+        std::unique_ptr<MixerBackend> m_mixer;
         bool m_muted = false;
     };
 
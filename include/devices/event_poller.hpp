@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <optional>
 #include <string>
 
 #include <sys/epoll.h>
@@ -8,6 +11,9 @@
 #include <cstring>
 #include <stdexcept>
 #include <sys/ioctl.h>
+#include <time.h>
+
+#include "events.hpp"
 
 namespace pwswd::dev {
 
@@ -16,14 +22,19 @@ namespace pwswd::dev {
         EventPoller(const std::string &eventPath) {
             this->m_epollfd = epoll_create1(0);
 
-            if (this->m_epollfd == 0)
+            if (this->m_epollfd == -1)
                 throw std::runtime_error("Failed to create epoll!");
 
             this->m_eventfd = open(eventPath.c_str(), O_RDONLY | O_NONBLOCK);
 
-            if (this->m_eventfd == 0)
+            if (this->m_eventfd == -1)
                 throw std::runtime_error("Failed to open event!");
 
+            // Timestamp events with the monotonic clock so they can be compared to the loop's timers. Old kernels stay on the realtime clock
+            int clock = CLOCK_MONOTONIC;
+            if (ioctl(this->m_eventfd, IoCtlCommandEventSetClockId, &clock) != -1)
+                this->m_clock = clock;
+
             this->m_eventData.events = EPOLLIN;
             this->m_eventData.data.fd = this->m_eventfd;
 
@@ -49,6 +60,69 @@ namespace pwswd::dev {
             return data;
         }
 
+        /**
+         * Drains all pending events with a single read() and hands every complete
+         * SYN_REPORT delimited frame to the callback. Events of a frame that hasn't
+         * been terminated yet are kept around until the next call.
+         * Returns the number of events that were read.
+         */
+        template<typename Callback>
+        std::size_t readFrames(Callback callback) {
+            auto buffer = reinterpret_cast<std::uint8_t*>(this->m_ring.data());
+
+            ssize_t bytesRead = read(this->m_eventfd, buffer + this->m_bufferedBytes, sizeof(this->m_ring) - this->m_bufferedBytes);
+            if (bytesRead <= 0)
+                return 0;
+
+            this->m_bufferedBytes += bytesRead;
+
+            std::size_t eventCount = this->m_bufferedBytes / sizeof(InputEvent);
+            std::size_t frameStart = 0;
+
+            for (std::size_t i = 0; i < eventCount; i++) {
+                const auto &event = this->m_ring[i];
+
+                if (event.type != static_cast<std::uint16_t>(EventType::Synchronization))
+                    continue;
+
+                switch (static_cast<SynchronizationEvent>(event.code)) {
+                    case SynchronizationEvent::Report:
+                        if (this->m_dropped) {
+                            // Everything up to this report is incomplete, rebuild the state from the device instead
+                            this->m_dropped = false;
+                            this->resynchronize(event.time, callback);
+                        } else {
+                            this->trackFrame(frameStart, i - frameStart);
+                            callback(InputFrame { &this->m_ring[frameStart], i - frameStart });
+                        }
+                        frameStart = i + 1;
+                        break;
+                    case SynchronizationEvent::Dropped:
+                        // The kernel's buffer overflowed, discard everything until the next report
+                        this->m_dropped = true;
+                        frameStart = i + 1;
+                        break;
+                    default: break;
+                }
+            }
+
+            // A frame that doesn't fit into the ring at all gets delivered as is
+            if (frameStart == 0 && eventCount == this->m_ring.size()) {
+                if (!this->m_dropped) {
+                    this->trackFrame(0, eventCount);
+                    callback(InputFrame { this->m_ring.data(), eventCount });
+                }
+                frameStart = eventCount;
+            }
+
+            // Move the unterminated frame and any partially read event to the front of the ring
+            std::size_t consumedBytes = frameStart * sizeof(InputEvent);
+            this->m_bufferedBytes -= consumedBytes;
+            std::memmove(buffer, buffer + consumedBytes, this->m_bufferedBytes);
+
+            return bytesRead / sizeof(InputEvent);
+        }
+
         template<typename T>
         void inject(T data) {
             write(this->m_eventfd, &data, sizeof(T));
@@ -76,12 +150,109 @@ namespace pwswd::dev {
             return this->m_grabbed;
         }
 
+        [[nodiscard]] int getFd() {
+            return this->m_eventfd;
+        }
+
+        // Current time in microseconds on the clock events get timestamped with
+        [[nodiscard]] std::uint64_t getCurrentTime() const {
+            timespec time;
+            clock_gettime(this->m_clock, &time);
+
+            return std::uint64_t(time.tv_sec) * 1'000'000 + time.tv_nsec / 1000;
+        }
+
+        // Range, fuzz and flat area the driver reports for an absolute axis, nothing if it doesn't have that axis
+        [[nodiscard]] std::optional<InputAbsInfo> getAbsInfo(std::uint16_t axis) {
+            InputAbsInfo absInfo = { 0 };
+
+            if (axis > AbsMax || ioctl(this->m_eventfd, ioCtlCommandEventGetAbsInfo(axis), &absInfo) < 0)
+                return std::nullopt;
+
+            return absInfo;
+        }
+
+        static constexpr std::size_t RingSize = 64;
+
     private:
-        static constexpr std::uint32_t IoCtlCommandEventGrab = 0x8004'4590;
+        static constexpr std::uint16_t KeyMax = 0x2FF;
+        static constexpr std::uint16_t AbsMax = 0x3F;
+
+        static constexpr std::uint32_t IoCtlCommandEventGrab = _IOW('E', 0x90, int);
+        static constexpr std::uint32_t IoCtlCommandEventSetClockId = _IOW('E', 0xA0, int);
+        static constexpr std::uint32_t IoCtlCommandEventGetKeyState = _IOC(_IOC_READ, 'E', 0x18, (KeyMax + 1) / 8);
+
+        static constexpr std::uint32_t ioCtlCommandEventGetAbsInfo(std::uint16_t axis) {
+            return _IOR('E', 0x40 + axis, InputAbsInfo);
+        }
 
         int m_epollfd, m_eventfd;
         epoll_event m_eventData;
         bool m_grabbed = false;
+        clockid_t m_clock = CLOCK_REALTIME;
+
+        std::array<InputEvent, RingSize> m_ring;
+        std::size_t m_bufferedBytes = 0;
+        bool m_dropped = false;
+
+        std::bitset<KeyMax + 1> m_keyState;
+        std::bitset<AbsMax + 1> m_absSeen;
+        std::array<std::int32_t, AbsMax + 1> m_absState = { 0 };
+
+        void trackFrame(std::size_t start, std::size_t count) {
+            for (std::size_t i = start; i < start + count; i++) {
+                const auto &event = this->m_ring[i];
+
+                if (event.type == static_cast<std::uint16_t>(EventType::Buttons) && event.code <= KeyMax) {
+                    this->m_keyState[event.code] = event.value != static_cast<std::int32_t>(ButtonState::Released);
+                } else if (event.type == static_cast<std::uint16_t>(EventType::AbsoluteAxes) && event.code <= AbsMax) {
+                    this->m_absSeen[event.code] = true;
+                    this->m_absState[event.code] = event.value;
+                }
+            }
+        }
+
+        template<typename Callback>
+        void resynchronize(timeval time, Callback callback) {
+            std::array<InputEvent, RingSize> frame;
+            std::size_t count = 0;
+
+            auto addEvent = [&](EventType type, std::uint16_t code, std::int32_t value) {
+                if (count < frame.size())
+                    frame[count++] = { time, static_cast<std::uint16_t>(type), code, value };
+            };
+
+            // Emit press / release events for every key whose state changed while events were dropped
+            std::uint8_t keyState[(KeyMax + 1) / 8] = { 0 };
+            if (ioctl(this->m_eventfd, IoCtlCommandEventGetKeyState, keyState) >= 0) {
+                for (std::uint16_t key = 0; key <= KeyMax; key++) {
+                    bool pressed = keyState[key / 8] & (1 << (key % 8));
+
+                    if (pressed != this->m_keyState[key]) {
+                        this->m_keyState[key] = pressed;
+                        addEvent(EventType::Buttons, key, static_cast<std::int32_t>(pressed ? ButtonState::Pressed : ButtonState::Released));
+                    }
+                }
+            }
+
+            // Re-read the current position of every axis that was reported before
+            for (std::uint16_t axis = 0; axis <= AbsMax; axis++) {
+                if (!this->m_absSeen[axis])
+                    continue;
+
+                InputAbsInfo absInfo = { 0 };
+                if (ioctl(this->m_eventfd, ioCtlCommandEventGetAbsInfo(axis), &absInfo) < 0)
+                    continue;
+
+                if (absInfo.value != this->m_absState[axis]) {
+                    this->m_absState[axis] = absInfo.value;
+                    addEvent(EventType::AbsoluteAxes, axis, absInfo.value);
+                }
+            }
+
+            if (count > 0)
+                callback(InputFrame { frame.data(), count });
+        }
     };
 
 }
\ No newline at end of file
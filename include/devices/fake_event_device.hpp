@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <initializer_list>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "events.hpp"
+
+namespace pwswd::dev {
+
+    /**
+     * Pipe backed stand-in for an evdev device. Opening getPath() yields the read end,
+     * so an EventPoller can be pointed at it without any kernel input device present.
+     */
+    class FakeEventDevice {
+    public:
+        FakeEventDevice() {
+            if (pipe2(this->m_pipefds, O_NONBLOCK | O_CLOEXEC) == -1)
+                throw std::runtime_error("Failed to create fake event device!");
+        }
+
+        ~FakeEventDevice() {
+            close(this->m_pipefds[0]);
+            close(this->m_pipefds[1]);
+        }
+
+        [[nodiscard]] std::string getPath() {
+            return "/proc/self/fd/" + std::to_string(this->m_pipefds[0]);
+        }
+
+        void inject(const InputEvent &event) {
+            write(this->m_pipefds[1], &event, sizeof(InputEvent));
+        }
+
+        // Writes all events followed by a SYN_REPORT with a single write()
+        void injectFrame(std::initializer_list<InputEvent> events) {
+            std::vector<InputEvent> frame(events);
+            frame.push_back(createSyncEvent());
+
+            write(this->m_pipefds[1], frame.data(), frame.size() * sizeof(InputEvent));
+        }
+
+    private:
+        int m_pipefds[2];
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "framebuffer.hpp"
+
+namespace pwswd::dev {
+
+    /**
+     * memfd backed stand-in for a framebuffer device. The memory layout matches what the
+     * driver would expose, so drawing code can run against it without any display present.
+     */
+    class FakeFramebuffer {
+    public:
+        FakeFramebuffer(std::uint32_t xres, std::uint32_t yres, std::uint32_t bitsPerPixel)
+            : m_memoryFile(createMemoryFile(xres, yres, bitsPerPixel)),
+              m_framebuffer(this->m_memoryFile, createFixScreenInfo(xres, bitsPerPixel), createVarScreenInfo(xres, yres, bitsPerPixel)) {
+            this->m_framebuffer.map();
+        }
+
+        [[nodiscard]] Framebuffer& get() {
+            return this->m_framebuffer;
+        }
+
+        // Simulates the application flipping to another page
+        void flip(std::uint8_t page) {
+            this->m_framebuffer.pan(page * this->m_framebuffer.getResolution().second);
+        }
+
+        // Simulates the application switching to another mode, like the driver it starts out on the first page
+        void setMode(std::uint32_t xres, std::uint32_t yres, std::uint32_t bitsPerPixel) {
+            if (!resize(this->m_memoryFile, xres, yres, bitsPerPixel))
+                throw std::runtime_error("Failed to resize fake framebuffer!");
+
+            this->m_framebuffer.setScreenInfo(createFixScreenInfo(xres, bitsPerPixel), createVarScreenInfo(xres, yres, bitsPerPixel));
+        }
+
+    private:
+        int m_memoryFile;
+        Framebuffer m_framebuffer;
+
+        static std::uint32_t getLineLength(std::uint32_t xres, std::uint32_t bitsPerPixel) {
+            return xres * ((bitsPerPixel + 7) / 8);
+        }
+
+        static int createMemoryFile(std::uint32_t xres, std::uint32_t yres, std::uint32_t bitsPerPixel) {
+            int fd = memfd_create("pwswdpp-framebuffer", MFD_CLOEXEC);
+
+            if (fd == -1)
+                throw std::runtime_error("Failed to create fake framebuffer!");
+
+            if (!resize(fd, xres, yres, bitsPerPixel)) {
+                close(fd);
+                throw std::runtime_error("Failed to resize fake framebuffer!");
+            }
+
+            return fd;
+        }
+
+        // Only ever grows, pages of a smaller mode are still backed by memory
+        static bool resize(int fd, std::uint32_t xres, std::uint32_t yres, std::uint32_t bitsPerPixel) {
+            const off_t size = off_t(getLineLength(xres, bitsPerPixel)) * yres * Framebuffer::NumFramebuffers;
+
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size >= size)
+                return true;
+
+            return ftruncate(fd, size) != -1;
+        }
+
+        static fb_fix_screeninfo createFixScreenInfo(std::uint32_t xres, std::uint32_t bitsPerPixel) {
+            fb_fix_screeninfo fixScreenInfo = { 0 };
+            fixScreenInfo.line_length = getLineLength(xres, bitsPerPixel);
+
+            return fixScreenInfo;
+        }
+
+        static fb_var_screeninfo createVarScreenInfo(std::uint32_t xres, std::uint32_t yres, std::uint32_t bitsPerPixel) {
+            fb_var_screeninfo varScreenInfo = { 0 };
+            varScreenInfo.xres = varScreenInfo.xres_virtual = xres;
+            varScreenInfo.yres = yres;
+            varScreenInfo.yres_virtual = yres * Framebuffer::NumFramebuffers;
+            varScreenInfo.bits_per_pixel = bitsPerPixel;
+
+            // Same layouts the panel drivers report, RGB565 or XRGB8888
+            if (bitsPerPixel == 16) {
+                varScreenInfo.red   = { 11, 5, 0 };
+                varScreenInfo.green = { 5, 6, 0 };
+                varScreenInfo.blue  = { 0, 5, 0 };
+            } else {
+                varScreenInfo.red   = { 16, 8, 0 };
+                varScreenInfo.green = { 8, 8, 0 };
+                varScreenInfo.blue  = { 0, 8, 0 };
+            }
+
+            return varScreenInfo;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace pwswd::dev {
+
+    /**
+     * Temporary directory standing in for /proc. Open files of a process are symlinks in
+     * <pid>/fd, just like the real thing, so HolderResolver can't tell the difference.
+     * Everything that's been created gets removed again on destruction.
+     */
+    class FakeProc {
+    public:
+        FakeProc() {
+            char path[] = "/tmp/pwswdpp-proc-XXXXXX";
+
+            if (mkdtemp(path) == nullptr)
+                throw std::runtime_error("Failed to create fake proc!");
+
+            this->m_root = path;
+        }
+
+        ~FakeProc() {
+            for (auto it = this->m_created.rbegin(); it != this->m_created.rend(); it++)
+                ::remove(it->c_str());
+
+            ::rmdir(this->m_root.c_str());
+        }
+
+        FakeProc(const FakeProc&) = delete;
+        FakeProc& operator=(const FakeProc&) = delete;
+
+        [[nodiscard]] const std::string& getRoot() const {
+            return this->m_root;
+        }
+
+        // Makes the process with the given name look like it has the target open as fd. Targets don't have to be paths, e.g. "pipe:[1234]"
+        void addFile(const std::string &process, int fd, const std::string &target) {
+            this->addDirectory("/" + process);
+            this->addDirectory("/" + process + "/fd");
+
+            const std::string linkPath = this->m_root + "/" + process + "/fd/" + std::to_string(fd);
+            if (::symlink(target.c_str(), linkPath.c_str()) != 0)
+                throw std::runtime_error("Failed to create fake proc fd " + linkPath);
+
+            this->m_created.push_back(linkPath);
+        }
+
+        void addFile(pid_t pid, int fd, const std::string &target) {
+            this->addFile(std::to_string(pid), fd, target);
+        }
+
+    private:
+        std::string m_root;
+        std::vector<std::string> m_created;
+
+        void addDirectory(const std::string &path) {
+            const std::string directory = this->m_root + path;
+
+            if (::mkdir(directory.c_str(), 0755) == 0)
+                this->m_created.push_back(directory);
+        }
+    };
+
+}
\ No newline at end of file
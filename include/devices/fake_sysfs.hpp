@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pwswd::dev {
+
+    /**
+     * Temporary directory standing in for /sys. Attributes are plain files, SysfsAttribute
+     * truncates them on every write so they behave like the real thing. Everything that's
+     * been created gets removed again on destruction.
+     */
+    class FakeSysfs {
+    public:
+        FakeSysfs() {
+            char path[] = "/tmp/pwswdpp-sysfs-XXXXXX";
+
+            if (mkdtemp(path) == nullptr)
+                throw std::runtime_error("Failed to create fake sysfs!");
+
+            this->m_root = path;
+        }
+
+        ~FakeSysfs() {
+            for (auto it = this->m_created.rbegin(); it != this->m_created.rend(); it++)
+                ::remove(it->c_str());
+
+            ::rmdir(this->m_root.c_str());
+        }
+
+        FakeSysfs(const FakeSysfs&) = delete;
+        FakeSysfs& operator=(const FakeSysfs&) = delete;
+
+        [[nodiscard]] const std::string& getRoot() const {
+            return this->m_root;
+        }
+
+        // Creates an attribute and all directories leading up to it, the path is relative to the root and starts with a slash
+        void addAttribute(const std::string &path, std::string_view value) {
+            for (std::size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+                const std::string directory = this->m_root + path.substr(0, slash);
+
+                if (::mkdir(directory.c_str(), 0755) == 0)
+                    this->m_created.push_back(directory);
+            }
+
+            const std::string filePath = this->m_root + path;
+            int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd == -1)
+                throw std::runtime_error("Failed to create fake sysfs attribute " + path);
+
+            ::write(fd, value.data(), value.size());
+            ::close(fd);
+
+            this->m_created.push_back(filePath);
+        }
+
+    private:
+        std::string m_root;
+        std::vector<std::string> m_created;
+    };
+
+}
\ No newline at end of file
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
+#include <cerrno>
 #include <stdexcept>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <poll.h>
 #include <mutex>
+#include <type_traits>
+#include <variant>
+
+#include "gfx/blend.hpp"
+#include "gfx/pixel_format.hpp"
+#include "gfx/span_fill.hpp"
+#include "gfx/surface.hpp"
 
 namespace pwswd::dev {
 
@@ -69,6 +78,18 @@ namespace pwswd::dev {
    };
 
 
+    struct Rect {
+        std::uint32_t x, y, w, h;
+
+        [[nodiscard]] bool empty() const {
+            return this->w == 0 || this->h == 0;
+        }
+
+        bool operator==(const Rect &other) const {
+            return this->x == other.x && this->y == other.y && this->w == other.w && this->h == other.h;
+        }
+    };
+
     class Framebuffer {
     public:
         Framebuffer(const std::string& fbPath) : m_fbPath(fbPath) {
@@ -86,7 +107,21 @@ namespace pwswd::dev {
             this->refreshScreenInfo();
         }
 
+        // Wraps an already opened memory file instead of a framebuffer device, the screen info is fixed
+        Framebuffer(int framebufferfd, const fb_fix_screeninfo &fixScreenInfo, const fb_var_screeninfo &varScreenInfo)
+            : m_framebufferfd(framebufferfd), m_virtual(true), m_fixScreenInfo(fixScreenInfo), m_varScreenInfo(varScreenInfo) {
+            this->updatePixelFormat();
+        }
+
+        ~Framebuffer() {
+            this->unmap();
+            this->close();
+        }
+
         bool open() {
+            if (this->m_virtual)
+                return true;
+
             if (this->m_framebufferfd == -1)
                 this->m_framebufferfd = ::open(this->m_fbPath.c_str(), O_RDWR);
 
@@ -94,6 +129,9 @@ namespace pwswd::dev {
         }
 
         void close() {
+            if (this->m_virtual)
+                return;
+
             if (this->m_framebufferfd != -1)
                 ::close(this->m_framebufferfd);
             this->m_framebufferfd = -1;
@@ -122,19 +160,151 @@ namespace pwswd::dev {
         }
 
         void refreshScreenInfo() {
-            if (ioctl(this->m_framebufferfd, IoCtlCommandFramebufferGetVScreenInfo, &this->m_varScreenInfo) < 0)
+            if (this->m_virtual)
+                return;
+
+            fb_var_screeninfo varScreenInfo;
+            if (ioctl(this->m_framebufferfd, IoCtlCommandFramebufferGetVScreenInfo, &varScreenInfo) < 0)
                 throw std::runtime_error("Failed to get variable screen info!");
+
+            // The line length only changes along with the mode, page flips just move the offsets
+            fb_fix_screeninfo fixScreenInfo = this->m_fixScreenInfo;
+            if (this->isModeChange(varScreenInfo) && ioctl(this->m_framebufferfd, IoCtlCommandFramebufferGetFScreenInfo, &fixScreenInfo) < 0)
+                throw std::runtime_error("Failed to get fixed screen info!");
+
+            this->setScreenInfo(fixScreenInfo, varScreenInfo);
+        }
+
+        /**
+         * Takes over a new screen layout. If the mode changed the mapping is redone once the pages don't fit
+         * into it anymore and the layout version goes up, so nothing keeps pixels around in the old layout.
+         */
+        void setScreenInfo(const fb_fix_screeninfo &fixScreenInfo, const fb_var_screeninfo &varScreenInfo) {
+            const bool modeChanged = this->isModeChange(varScreenInfo) || fixScreenInfo.line_length != this->m_fixScreenInfo.line_length;
+
+            this->m_fixScreenInfo = fixScreenInfo;
+            this->m_varScreenInfo = varScreenInfo;
+
+            if (!modeChanged)
+                return;
+
+            this->m_layoutVersion++;
+            this->updatePixelFormat();
+
+            if (this->m_framebuffer != nullptr && this->getMappingSize() > this->m_mappedSize) {
+                this->unmap();
+                this->map();
+            }
+        }
+
+        // Changes whenever the resolution, pixel format or pitch changed
+        [[nodiscard]] std::uint32_t getLayoutVersion() {
+            return this->m_layoutVersion;
+        }
+
+        [[nodiscard]] const pwswd::gfx::AnyPixelFormat& getPixelFormat() {
+            return this->m_pixelFormat;
+        }
+
+        /**
+         * Calls the callback with the pixel format type matching the current screen layout.
+         * Draw code should do this once per frame and use the typed draw functions inside.
+         */
+        template<typename Callback>
+        void withPixelFormat(Callback callback) {
+            std::visit([&](auto format) {
+                if constexpr (!std::is_same_v<decltype(format), std::monostate>)
+                    callback(format);
+            }, this->m_pixelFormat);
+        }
+
+        [[nodiscard]] std::uint32_t getPitch() {
+            return this->m_fixScreenInfo.line_length;
+        }
+
+        // Byte offset of the page that's currently being scanned out
+        [[nodiscard]] std::size_t getVisiblePageOffset() {
+            return std::size_t(this->m_varScreenInfo.yoffset) * this->getPitch() + std::size_t(this->m_varScreenInfo.xoffset) * this->getStride();
+        }
+
+        // Checks if the visible page lies within the mapped memory, a mode change may have made it bigger
+        [[nodiscard]] bool isVisiblePageMapped() {
+            return this->m_framebuffer != nullptr && this->getVisiblePageOffset() + this->getSize() <= this->m_mappedSize;
+        }
+
+        // Handle to wait for vertical blanks on, -1 for memory files or while the device is closed. Changes when the device is reopened
+        [[nodiscard]] int getVSyncHandle() {
+            if (this->m_virtual)
+                return -1;
+
+            return this->m_framebufferfd;
+        }
+
+        // Blocks until the next vertical blank. Returns false if the driver doesn't support waiting for it
+        static bool waitForVSync(int vsyncHandle) {
+            std::uint32_t screen = 0;
+
+            return ioctl(vsyncHandle, IoCtlCommandFramebufferWaitForVSync, &screen) >= 0;
+        }
+
+        // Duration of a whole frame including blanking in microseconds, assumes 60Hz if the driver doesn't report timings
+        [[nodiscard]] std::uint32_t getRefreshPeriod() {
+            const auto &info = this->m_varScreenInfo;
+
+            if (info.pixclock == 0)
+                return DefaultRefreshPeriod;
+
+            std::uint64_t lineTime = std::uint64_t(info.xres + info.left_margin + info.right_margin + info.hsync_len) * info.pixclock;
+            return (lineTime * (info.yres + info.upper_margin + info.lower_margin + info.vsync_len)) / 1'000'000;
+        }
+
+        // Time between the end of the last visible line and the start of the next frame in microseconds
+        [[nodiscard]] std::uint32_t getBlankingPeriod() {
+            const auto &info = this->m_varScreenInfo;
+
+            if (info.pixclock == 0)
+                return DefaultBlankingPeriod;
+
+            std::uint64_t lineTime = std::uint64_t(info.xres + info.left_margin + info.right_margin + info.hsync_len) * info.pixclock;
+            return (lineTime * (info.upper_margin + info.lower_margin + info.vsync_len)) / 1'000'000;
+        }
+
+        // The visible page as a surface to draw to, empty if it isn't mapped
+        [[nodiscard]] pwswd::gfx::Surface getVisibleSurface() {
+            if (!this->isVisiblePageMapped())
+                return { nullptr, this->getPitch(), 0, 0, static_cast<std::uint8_t>(this->getStride()) };
+
+            auto [xres, yres] = this->getResolution();
+            return { &this->getAddress()[this->getVisiblePageOffset()], this->getPitch(), xres, yres, static_cast<std::uint8_t>(this->getStride()) };
+        }
+
+        void pan(std::uint32_t yoffset) {
+            auto varScreenInfo = this->m_varScreenInfo;
+            varScreenInfo.yoffset = yoffset;
+
+            if (this->m_virtual || ioctl(this->m_framebufferfd, IoCtlCommandFramebufferPanDisplay, &varScreenInfo) >= 0)
+                this->m_varScreenInfo.yoffset = yoffset;
         }
 
         void map() {
-            if (this->m_framebuffer == nullptr)
-                this->m_framebuffer = static_cast<std::uint8_t*>(mmap(nullptr, this->getSize() * NumFramebuffers, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_framebufferfd, 0));
+            if (this->m_framebuffer != nullptr)
+                return;
+
+            std::size_t size = this->getMappingSize();
+
+            void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_framebufferfd, 0);
+            if (address == MAP_FAILED)
+                return;
+
+            this->m_framebuffer = static_cast<std::uint8_t*>(address);
+            this->m_mappedSize = size;
         }
 
         void unmap() {
             if (this->m_framebuffer != nullptr)
-                munmap(this->m_framebuffer, this->getSize() * NumFramebuffers);
+                munmap(this->m_framebuffer, this->m_mappedSize);
             this->m_framebuffer = nullptr;
+            this->m_mappedSize = 0;
         }
 
         void lock() {
@@ -150,30 +320,74 @@ namespace pwswd::dev {
         }
 
         inline std::uint32_t encodeColor(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
-            switch (this->getBitsPerPixel()) {
-                case 15: return ((b & 0x1F) << 10) | ((g & 0x1F) << 5) | (r & 0x1F);
-                case 16: return ((b & 0x1F) << 11) | ((g & 0x3F) << 5) | (r & 0x1F);
-                case 24: return (b << 16) | (g << 8) | (r);
-                case 32: return (a << 24) | (b << 16) | (g << 8) | (r);
-                default: return 0x00;
-            }
+            std::uint32_t encodedColor = 0x00;
+
+            this->withPixelFormat([&](auto format) {
+                encodedColor = decltype(format)::encode(r, g, b, a);
+            });
+
+            return encodedColor;
         }
 
-        inline void drawRect(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t color) {
+        // Converts a rect from the 640x480 overlay coordinate space to screen coordinates
+        [[nodiscard]] Rect scaleRect(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h) {
             auto [xres, yres] = this->getResolution();
 
-            auto bpp = this->getStride();
-            auto encodedColor = this->encodeColor((color & 0xFF000000) >> 24, (color & 0x00FF0000) >> 16, (color & 0x0000FF00) >> 8, (color & 0x000000FF));
+            return {
+                (x * xres) / ScreenWidth,
+                (y * yres) / ScreenHeight,
+                (w * xres) / ScreenWidth,
+                (h * yres) / ScreenHeight
+            };
+        }
+
+        [[nodiscard]] Rect clipRect(const Rect &rect) {
+            auto [xres, yres] = this->getResolution();
+
+            if (rect.x >= xres || rect.y >= yres)
+                return { 0, 0, 0, 0 };
+
+            return { rect.x, rect.y, std::min(rect.w, xres - rect.x), std::min(rect.h, yres - rect.y) };
+        }
+
+        inline void drawRect(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t color) {
+            this->fillRect(this->scaleRect(x, y, w, h), color);
+        }
+
+        inline void fillRect(const Rect &rect, std::uint32_t color) {
+            this->withPixelFormat([&](auto format) {
+                this->fillRect<decltype(format)>(rect, color);
+            });
+        }
+
+        template<typename Format>
+        inline void fillRect(const Rect &rect, std::uint32_t color) {
+            // Only the page that's being scanned out needs to be drawn to, the others get overwritten before being shown
+            if ((color & 0xFF) == 0xFF)
+                pwswd::gfx::fillRect<Format>(this->getVisibleSurface(), rect.x, rect.y, rect.w, rect.h, color);
+            else
+                pwswd::gfx::blendRect<Format>(this->getVisibleSurface(), rect.x, rect.y, rect.w, rect.h, color);
+        }
 
-            std::uint32_t realX = (x * xres) / ScreenWidth,
-                          realY = (y * yres) / ScreenHeight, 
-                          realW = (w * xres) / ScreenWidth, 
-                          realH = (h * yres) / ScreenHeight;
+        // Number of bytes needed to back up a rect
+        [[nodiscard]] std::size_t getRectSize(const Rect &rect) {
+            return rect.w * rect.h * this->getStride();
+        }
+
+        // Copies the pixels of a rect from the given page into a packed buffer
+        void saveRect(const Rect &rect, std::uint8_t *buffer, std::size_t pageOffset) {
+            this->forEachRow(rect, pageOffset, [&](std::uint8_t *row, std::size_t rowSize) {
+                std::memcpy(buffer, row, rowSize);
+                buffer += rowSize;
+            });
+        }
 
-            for (std::uint8_t fb = 0; fb < NumFramebuffers; fb++)
-                for (std::uint32_t drawX = realX; drawX < (realX + realW); drawX++)
-                    for (std::uint32_t drawY = realY; drawY < (realY + realH); drawY++)
-                        std::memcpy(&this->getAddress()[(fb * xres * yres * bpp) + (drawY * xres * bpp) + (drawX * bpp)], std::addressof(encodedColor), bpp);
+        // Writes pixels saved with saveRect back to the page they were taken from
+        void restoreRect(const Rect &rect, const std::uint8_t *buffer, std::size_t pageOffset) {
+            this->forEachRow(rect, pageOffset, [&](std::uint8_t *row, std::size_t rowSize) {
+                std::memcpy(row, buffer, rowSize);
+                buffer += rowSize;
+            });
         }
 
 
@@ -187,16 +401,60 @@ namespace pwswd::dev {
     private:
         static constexpr std::uint32_t IoCtlCommandFramebufferGetVScreenInfo = ('F' << 8) | 0x00;
         static constexpr std::uint32_t IoCtlCommandFramebufferGetFScreenInfo = ('F' << 8) | 0x02;
+        static constexpr std::uint32_t IoCtlCommandFramebufferPanDisplay = ('F' << 8) | 0x06;
+        static constexpr std::uint32_t IoCtlCommandFramebufferWaitForVSync = _IOW('F', 0x20, std::uint32_t);
+
+        static constexpr std::uint32_t DefaultRefreshPeriod = 16'667;
+        static constexpr std::uint32_t DefaultBlankingPeriod = 1'000;
 
         std::string m_fbPath;
         std::mutex m_lock;
 
         int m_framebufferfd = -1;
+        bool m_virtual = false;
 
         fb_fix_screeninfo m_fixScreenInfo;
         fb_var_screeninfo m_varScreenInfo;
 
         std::uint8_t *m_framebuffer = nullptr;
+        std::size_t m_mappedSize = 0;
+
+        pwswd::gfx::AnyPixelFormat m_pixelFormat;
+        std::uint32_t m_layoutVersion = 0;
+
+        // Map all pages the driver flips between, not just the visible one
+        [[nodiscard]] std::size_t getMappingSize() {
+            return std::size_t(this->getPitch()) * std::max(this->m_varScreenInfo.yres_virtual, this->m_varScreenInfo.yres);
+        }
+
+        // Anything but the pan offsets differs, the struct has no padding so it can be compared as a whole
+        [[nodiscard]] bool isModeChange(const fb_var_screeninfo &varScreenInfo) {
+            fb_var_screeninfo current = this->m_varScreenInfo;
+            current.xoffset = varScreenInfo.xoffset;
+            current.yoffset = varScreenInfo.yoffset;
+
+            return std::memcmp(&current, &varScreenInfo, sizeof(fb_var_screeninfo)) != 0;
+        }
+
+        void updatePixelFormat() {
+            const auto &info = this->m_varScreenInfo;
+
+            this->m_pixelFormat = pwswd::gfx::findPixelFormat(info.bits_per_pixel,
+                                                              info.red.offset, info.red.length,
+                                                              info.green.offset, info.green.length,
+                                                              info.blue.offset, info.blue.length);
+        }
+
+        template<typename Callback>
+        void forEachRow(const Rect &rect, std::size_t pageOffset, Callback callback) {
+            auto bpp = this->getStride();
+
+            if (this->m_framebuffer == nullptr || pageOffset + this->getSize() > this->m_mappedSize)
+                return;
+
+            for (std::uint32_t row = rect.y; row < (rect.y + rect.h); row++)
+                callback(&this->getAddress()[pageOffset + (row * this->getPitch()) + (rect.x * bpp)], rect.w * bpp);
+        }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+namespace pwswd::dev {
+
+    /**
+     * Finds the processes that have a file open by walking <procRoot>/<pid>/fd, the same way
+     * fuser does, but without spawning a process. Files are matched by device number so
+     * different paths to the same device node are recognized as well.
+     */
+    class HolderResolver {
+    public:
+        HolderResolver(const std::string &procRoot = "/proc") : m_procRoot(procRoot) { }
+
+        // Scans all processes once and returns the holders of each path, in the order the paths were given
+        [[nodiscard]] std::vector<std::vector<pid_t>> findHoldersOfEach(const std::vector<std::string> &paths) {
+            std::vector<FileId> targets;
+            for (const auto &path : paths)
+                targets.push_back(getFileId(path));
+
+            std::vector<std::vector<pid_t>> holders(paths.size());
+
+            int procfd = open(this->m_procRoot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (procfd == -1)
+                return holders;
+
+            DIR *procDir = fdopendir(procfd);
+            if (procDir == nullptr) {
+                close(procfd);
+                return holders;
+            }
+
+            while (auto entry = readdir(procDir)) {
+                pid_t pid = parsePid(entry->d_name);
+                if (pid <= 0 || pid == getpid())
+                    continue;
+
+                auto held = this->getHeldTargets(procfd, entry->d_name, targets);
+                for (std::size_t i = 0; i < targets.size(); i++)
+                    if (held[i])
+                        holders[i].push_back(pid);
+            }
+
+            closedir(procDir);
+
+            for (std::size_t i = 0; i < paths.size(); i++)
+                this->m_cachedHolders[paths[i]] = holders[i];
+
+            return holders;
+        }
+
+        [[nodiscard]] std::vector<pid_t> findHolders(const std::string &path) {
+            return this->findHoldersOfEach({ path })[0];
+        }
+
+        // Re-checks only the processes found by the last scan of this path and falls back to a full scan if none of them hold it anymore
+        [[nodiscard]] std::vector<pid_t> findCachedHolders(const std::string &path) {
+            auto target = getFileId(path);
+            std::vector<pid_t> holders;
+
+            for (pid_t pid : this->m_cachedHolders[path])
+                if (this->isHolding(pid, target))
+                    holders.push_back(pid);
+
+            if (holders.empty())
+                return this->findHolders(path);
+
+            this->m_cachedHolders[path] = holders;
+            return holders;
+        }
+
+        static bool signal(const std::vector<pid_t> &pids, int signal) {
+            bool signaled = false;
+
+            for (pid_t pid : pids)
+                signaled |= kill(pid, signal) == 0;
+
+            return signaled;
+        }
+
+    private:
+        struct FileId {
+            dev_t device;
+            ino_t inode;
+            bool valid;
+
+            bool operator==(const FileId &other) const {
+                return this->valid && other.valid && this->device == other.device && this->inode == other.inode;
+            }
+        };
+
+        std::string m_procRoot;
+        std::map<std::string, std::vector<pid_t>> m_cachedHolders;
+
+        [[nodiscard]] static FileId toFileId(const struct stat &fileStat) {
+            // Device nodes are identified by the device they refer to, everything else by its inode
+            if (S_ISCHR(fileStat.st_mode) || S_ISBLK(fileStat.st_mode))
+                return { fileStat.st_rdev, 0, true };
+            else
+                return { fileStat.st_dev, fileStat.st_ino, true };
+        }
+
+        [[nodiscard]] static FileId getFileId(const std::string &path) {
+            struct stat fileStat;
+            if (stat(path.c_str(), &fileStat) != 0)
+                return { 0, 0, false };
+
+            return toFileId(fileStat);
+        }
+
+        [[nodiscard]] static pid_t parsePid(const char *name) {
+            char *end = nullptr;
+            long pid = std::strtol(name, &end, 10);
+
+            return (end != name && *end == '\0') ? pid : -1;
+        }
+
+        [[nodiscard]] bool isHolding(pid_t pid, const FileId &target) {
+            int procfd = open(this->m_procRoot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (procfd == -1)
+                return false;
+
+            bool holding = this->getHeldTargets(procfd, std::to_string(pid).c_str(), { target })[0];
+            close(procfd);
+
+            return holding;
+        }
+
+        [[nodiscard]] std::vector<bool> getHeldTargets(int procfd, const char *pidName, const std::vector<FileId> &targets) {
+            std::vector<bool> held(targets.size(), false);
+
+            int fdDirfd = openat(procfd, (std::string(pidName) + "/fd").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fdDirfd == -1)
+                return held;
+
+            DIR *fdDir = fdopendir(fdDirfd);
+            if (fdDir == nullptr) {
+                close(fdDirfd);
+                return held;
+            }
+
+            while (auto entry = readdir(fdDir)) {
+                if (entry->d_name[0] == '.')
+                    continue;
+
+                // Sockets, pipes and anonymous inodes don't link to a path, skip them without stat'ing
+                char link[2];
+                if (readlinkat(fdDirfd, entry->d_name, link, sizeof(link)) <= 0 || link[0] != '/')
+                    continue;
+
+                struct stat fileStat;
+                if (fstatat(fdDirfd, entry->d_name, &fileStat, 0) != 0)
+                    continue;
+
+                auto fileId = toFileId(fileStat);
+                for (std::size_t i = 0; i < targets.size(); i++)
+                    if (fileId == targets[i])
+                        held[i] = true;
+            }
+
+            closedir(fdDir);
+
+            return held;
+        }
+    };
+
+}
\ No newline at end of file
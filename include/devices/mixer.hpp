@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+namespace pwswd::dev {
+
+    struct SndCtlElemId {
+        std::uint32_t numid;
+        std::int32_t iface;
+        std::uint32_t device;
+        std::uint32_t subdevice;
+        char name[44];
+        std::uint32_t index;
+    };
+
+    struct SndCtlElemInfo {
+        SndCtlElemId id;
+        std::int32_t type;
+        std::uint32_t access;
+        std::uint32_t count;
+        std::int32_t owner;
+        union {
+            struct { long min; long max; long step; } integer;
+            struct { long long min; long long max; long long step; } integer64;
+            std::uint8_t reserved[128];
+        } value;
+        std::uint8_t reserved[64];
+    };
+
+    struct SndCtlElemValue {
+        SndCtlElemId id;
+        std::uint32_t indirect : 1;
+        union {
+            long integer[128];
+            long long integer64[64];
+            std::uint8_t data[512];
+        } value;
+        std::uint8_t reserved[128];
+    };
+
+    class MixerBackend {
+    public:
+        virtual ~MixerBackend() = default;
+
+        // Volumes are given in percent, backends that can't report the current volume return std::nullopt
+        [[nodiscard]] virtual std::optional<std::uint8_t> getVolume() = 0;
+        virtual void setVolume(std::uint8_t percentage) = 0;
+
+        virtual void changeVolume(std::int8_t step) {
+            auto volume = this->getVolume();
+            if (!volume.has_value())
+                return;
+
+            this->setVolume(std::clamp(static_cast<std::int32_t>(*volume) + step, 0, 100));
+        }
+    };
+
+    /**
+     * Volume logic shared by all backends that expose a raw integer element, the
+     * percentage is mapped linearly onto the element's range.
+     */
+    class IntegerMixer : public MixerBackend {
+    public:
+        [[nodiscard]] std::optional<std::uint8_t> getVolume() override {
+            auto raw = this->readRaw();
+            if (!raw.has_value())
+                return std::nullopt;
+
+            return this->toPercentage(*raw);
+        }
+
+        void setVolume(std::uint8_t percentage) override {
+            this->writeRaw(this->toRaw(percentage));
+        }
+
+        void changeVolume(std::int8_t step) override {
+            auto raw = this->readRaw();
+            if (!raw.has_value() || step == 0)
+                return;
+
+            long newRaw = this->toRaw(std::clamp(static_cast<std::int32_t>(this->toPercentage(*raw)) + step, 0, 100));
+
+            // Always move by at least one step so coarse elements don't get stuck due to rounding
+            if (newRaw == *raw)
+                newRaw = std::clamp(*raw + (step > 0 ? 1 : -1), this->m_minimum, this->m_maximum);
+
+            if (newRaw != *raw)
+                this->writeRaw(newRaw);
+        }
+
+    protected:
+        long m_minimum = 0, m_maximum = 0;
+
+        [[nodiscard]] virtual std::optional<long> readRaw() = 0;
+        virtual void writeRaw(long value) = 0;
+
+    private:
+        [[nodiscard]] std::uint8_t toPercentage(long raw) {
+            if (this->m_maximum <= this->m_minimum)
+                return 0;
+
+            return ((std::clamp(raw, this->m_minimum, this->m_maximum) - this->m_minimum) * 100 + (this->m_maximum - this->m_minimum) / 2) / (this->m_maximum - this->m_minimum);
+        }
+
+        [[nodiscard]] long toRaw(std::uint8_t percentage) {
+            return this->m_minimum + ((this->m_maximum - this->m_minimum) * std::min<std::uint8_t>(percentage, 100) + 50) / 100;
+        }
+    };
+
+    /**
+     * Talks to the ALSA control device directly. The element is looked up once and its
+     * id and range are cached, so changing the volume costs one read and one write ioctl.
+     */
+    class AlsaMixer : public IntegerMixer {
+    public:
+        AlsaMixer(const std::string &controlPath, const std::string &elementName) {
+            this->m_controlfd = open(controlPath.c_str(), O_RDWR | O_CLOEXEC);
+
+            if (this->m_controlfd == -1)
+                throw std::runtime_error("Failed to open mixer control device!");
+
+            SndCtlElemInfo info = { 0 };
+            info.id.iface = InterfaceMixer;
+            std::strncpy(info.id.name, elementName.c_str(), sizeof(SndCtlElemId::name) - 1);
+
+            if (ioctl(this->m_controlfd, IoCtlCommandSndCtlElemInfo, &info) < 0 || info.type != ElementTypeInteger || info.count == 0) {
+                close(this->m_controlfd);
+                throw std::runtime_error("Failed to find mixer element!");
+            }
+
+            this->m_elementId = { 0 };
+            this->m_elementId.numid = info.id.numid;
+            this->m_channels = std::min<std::uint32_t>(info.count, 128);
+            this->m_minimum = info.value.integer.min;
+            this->m_maximum = info.value.integer.max;
+        }
+
+        ~AlsaMixer() override {
+            close(this->m_controlfd);
+        }
+
+    protected:
+        [[nodiscard]] std::optional<long> readRaw() override {
+            SndCtlElemValue value = { 0 };
+            value.id = this->m_elementId;
+
+            if (ioctl(this->m_controlfd, IoCtlCommandSndCtlElemRead, &value) < 0)
+                return std::nullopt;
+
+            return value.value.integer[0];
+        }
+
+        void writeRaw(long raw) override {
+            SndCtlElemValue value = { 0 };
+            value.id = this->m_elementId;
+
+            for (std::uint32_t channel = 0; channel < this->m_channels; channel++)
+                value.value.integer[channel] = raw;
+
+            ioctl(this->m_controlfd, IoCtlCommandSndCtlElemWrite, &value);
+        }
+
+    private:
+        static constexpr std::int32_t InterfaceMixer = 2;
+        static constexpr std::int32_t ElementTypeInteger = 2;
+
+        static constexpr std::uint32_t IoCtlCommandSndCtlElemInfo = _IOWR('U', 0x11, SndCtlElemInfo);
+        static constexpr std::uint32_t IoCtlCommandSndCtlElemRead = _IOWR('U', 0x12, SndCtlElemValue);
+        static constexpr std::uint32_t IoCtlCommandSndCtlElemWrite = _IOWR('U', 0x13, SndCtlElemValue);
+
+        int m_controlfd;
+
+        SndCtlElemId m_elementId;
+        std::uint32_t m_channels;
+    };
+
+    // Fallback for systems without a usable control device, spawns amixer for every change
+    class AmixerMixer : public MixerBackend {
+    public:
+        AmixerMixer(const std::string &elementName) : m_elementName(elementName) { }
+
+        [[nodiscard]] std::optional<std::uint8_t> getVolume() override {
+            return std::nullopt;
+        }
+
+        void setVolume(std::uint8_t percentage) override {
+            char argument[7];
+            snprintf(argument, sizeof(argument), "%u%%", percentage);
+
+            this->run(argument);
+        }
+
+        void changeVolume(std::int8_t step) override {
+            char argument[7];
+            snprintf(argument, sizeof(argument), "%u%%%c", std::abs(step), step < 0 ? '-' : '+');
+
+            this->run(argument);
+        }
+
+    private:
+        std::string m_elementName;
+
+        void run(const char *argument) {
+            pid_t child = fork();
+
+            // argv[0] has to be the program name or amixer treats -M as such and uses the raw volume scale
+            if (!child) {
+                execlp("amixer", "amixer", "-M", "-q", "set", this->m_elementName.c_str(), argument, nullptr);
+                _exit(127);
+            }
+
+            if (child == -1)
+                return;
+
+            int status = 0;
+            waitpid(child, &status, 0);
+        }
+    };
+
+    // In-memory stand-in for an ALSA integer control element with the given range
+    class MockMixer : public IntegerMixer {
+    public:
+        MockMixer(long minimum = 0, long maximum = 255, std::uint32_t channels = 2) : m_values(channels, minimum) {
+            this->m_minimum = minimum;
+            this->m_maximum = maximum;
+        }
+
+        [[nodiscard]] long getRawValue(std::uint32_t channel = 0) {
+            return this->m_values[channel];
+        }
+
+        [[nodiscard]] std::uint64_t getWriteCount() {
+            return this->m_writeCount;
+        }
+
+    protected:
+        [[nodiscard]] std::optional<long> readRaw() override {
+            return this->m_values[0];
+        }
+
+        void writeRaw(long raw) override {
+            for (auto &value : this->m_values)
+                value = raw;
+
+            this->m_writeCount++;
+        }
+
+    private:
+        std::vector<long> m_values;
+
+        std::uint64_t m_writeCount = 0;
+    };
+
+}
\ No newline at end of file
@@ -1,27 +1,44 @@
 #pragma once
 
-#include <sys/wait.h>
+#include <string>
+
+#include <signal.h>
 
 #include "event_poller.hpp"
+#include "holder_resolver.hpp"
 #include "screen.hpp"
 
 namespace pwswd::dev {
 
     class Power {
     public:
-        Power() : m_buttonEvent(nullptr), m_screen(nullptr), m_isScreenOff(false) {}
+        explicit Power(const std::string &framebufferPath = FramebufferPath, const std::string &consolePath = ConsolePath)
+            : m_framebufferPath(framebufferPath), m_consolePath(consolePath), m_buttonEvent(nullptr), m_screen(nullptr), m_holderResolver(nullptr), m_isScreenOff(false) {}
 
-        void initialize(pwswd::dev::EventPoller *buttonEvent, pwswd::dev::Screen *screen) {
+        void initialize(pwswd::dev::EventPoller *buttonEvent, pwswd::dev::Screen *screen, pwswd::dev::HolderResolver *holderResolver) {
             this->m_buttonEvent = buttonEvent;
             this->m_screen = screen;
+            this->m_holderResolver = holderResolver;
+        }
+
+        // Only keeps track of the screen state instead of actually powering off, blanking or killing anything, e.g. while replaying a trace
+        void setDryRun(bool dryRun) {
+            this->m_dryRun = dryRun;
         }
 
         void powerOff() {
+            if (this->m_dryRun)
+                return;
+
             this->m_screen->enableBlanking();
             execlp("/sbin/poweroff", "/sbin/poweroff", nullptr);
         }
 
         void toggleSleepMode() {
+            if (this->m_dryRun) {
+                this->m_isScreenOff = !this->m_isScreenOff;
+                return;
+            }
 
             if (!this->m_isScreenOff) {
                 this->m_buttonEvent->grab();
@@ -37,28 +54,18 @@ namespace pwswd::dev {
         }
 
         void killForegroundApplication() {
-            // Kill framebuffer application
-            {
-                pid_t child = fork();
-                if (!child)
-                    execlp("fuser", "fuser", "-k", "-HUP", "/dev/fb0", nullptr);
+            if (this->m_dryRun)
+                return;
 
-                int status = 0;
-                waitpid(child, &status, 0);
+            // Look up framebuffer and console holders with a single walk over all processes
+            auto holders = this->m_holderResolver->findHoldersOfEach({ this->m_framebufferPath, this->m_consolePath });
 
-                if (!status)
-                    return;
-            }
+            // Kill framebuffer application
+            if (HolderResolver::signal(holders[0], SIGHUP))
+                return;
 
             // Kill console application
-            {
-                pid_t child = fork();
-                if (!child)
-                    execlp("fuser", "fuser", "-k", "-HUP", "/dev/tty1", nullptr);
-
-                int status = 0;
-                waitpid(child, &status, 0);
-            }
+            HolderResolver::signal(holders[1], SIGHUP);
         }
 
         bool isScreenOff() {
@@ -66,10 +73,17 @@ namespace pwswd::dev {
         }
 
     private:
+        static constexpr auto FramebufferPath = "/dev/fb0";
+        static constexpr auto ConsolePath = "/dev/tty1";
+
+        std::string m_framebufferPath, m_consolePath;
+
         pwswd::dev::EventPoller *m_buttonEvent;
         pwswd::dev::Screen *m_screen;
+        pwswd::dev::HolderResolver *m_holderResolver;
 
         bool m_isScreenOff;
+        bool m_dryRun = false;
     };
 
 }
\ No newline at end of file
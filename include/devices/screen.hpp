@@ -1,120 +1,102 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include <sys/epoll.h>
-#include <unistd.h>
-#include <fcntl.h>
 #include <cstring>
 #include <stdexcept>
+#include <signal.h>
+
+#include "holder_resolver.hpp"
+#include "sysfs_attribute.hpp"
 
 namespace pwswd::dev {
 
     class Screen {
     public:
-        Screen() {
-            this->m_blankingfd = open("/sys/class/graphics/fb0/blank", O_RDWR);
-            this->m_sharpnessUpscalingfd = open("/sys/devices/platform/jz-lcd.0/sharpness_upscaling", O_RDWR);
-            this->m_sharpnessDownscalingfd = open("/sys/devices/platform/jz-lcd.0/sharpness_downscaling", O_RDWR);
-            this->m_keepAspectRatiofd = open("/sys/devices/platform/jz-lcd.0/keep_aspect_ratio", O_RDWR);
-            this->m_integerScalingfd = open("/sys/devices/platform/jz-lcd.0/integer_scaling", O_RDWR);
-            this->m_brightnessfd = open("/sys/devices/platform/pwm-backlight/backlight/pwm-backlight/brightness", O_RDWR);
-
-            if (this->m_blankingfd == 0 || this->m_sharpnessUpscalingfd == 0 || this->m_sharpnessDownscalingfd == 0 || this->m_keepAspectRatiofd == 0 || this->m_brightnessfd == 0)
-                throw std::runtime_error("Failed to access framebuffer settings");
-
-            char buffer[10] = { 0 };
-            read(this->m_sharpnessUpscalingfd, buffer, 9);
-            this->m_sharpness = strtol(buffer, nullptr, 10);
-
-            read(this->m_keepAspectRatiofd, buffer, 1);
-            this->m_displayStyle = buffer[0] == 'Y';
-
-            read(this->m_integerScalingfd, buffer, 1);
-            this->m_displayStyle |= (buffer[0] == 'Y') << 1;
-            
+        static constexpr std::array<std::uint8_t, 22> DefaultBrightnessValues = { 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 19, 20, 25, 30, 35, 40, 45, 50, 80, 100, 150, 255 };
+
+        explicit Screen(const std::string &sysfsRoot = "/sys", const std::string &framebufferPath = FramebufferPath)
+            : m_framebufferPath(framebufferPath),
+              m_blanking(sysfsRoot + BlankingPath),
+              m_sharpnessUpscaling(sysfsRoot + SharpnessUpscalingPath),
+              m_sharpnessDownscaling(sysfsRoot + SharpnessDownscalingPath),
+              m_keepAspectRatio(sysfsRoot + KeepAspectRatioPath),
+              m_brightness(sysfsRoot + BrightnessPath) {
+
+            // Older kernels don't support integer scaling
+            try {
+                this->m_integerScaling = std::make_unique<SysfsAttribute>(sysfsRoot + IntegerScalingPath);
+            } catch (const std::runtime_error&) { }
+
+            this->m_sharpness = std::clamp<std::int32_t>(this->m_sharpnessUpscaling.readInteger(), 0, MaxSharpness);
+            this->m_sharpnessDownscaling.read();
+
+            this->m_displayStyle = this->m_keepAspectRatio.read() == "Y";
+
+            if (this->m_integerScaling != nullptr)
+                this->m_displayStyle |= (this->m_integerScaling->read() == "Y") << 1;
+
             std::uint8_t currBrightnessValue = this->getBrightness();
 
-            if (currBrightnessValue < BrightnessValues[0]) 
-                currBrightnessValue = BrightnessValues[19];
+            if (currBrightnessValue < this->m_brightnessValues[0]) 
+                currBrightnessValue = DefaultBrightness;
 
-            for (std::uint8_t i = 0; i < sizeof(BrightnessValues); i++) {
-                if (BrightnessValues[i] >= currBrightnessValue) {
-                    this->m_brightnessIndex = i;
-                    break;
-                }
-            }
+            this->m_brightnessIndex = this->findBrightnessIndex(currBrightnessValue);
 
             this->setBrightness(currBrightnessValue);
         }
 
-        ~Screen() {
-            close(this->m_blankingfd);
-            close(this->m_sharpnessUpscalingfd);
-            close(this->m_sharpnessDownscalingfd);
-        }
-
         void enableBlanking() {
-            write(this->m_brightnessfd, "1", 1);
+            this->m_brightness.write("1");
         }
 
         void disableBlanking() {
-            auto brightnessString = std::to_string(BrightnessValues[this->m_brightnessIndex]);
-            write(this->m_brightnessfd, brightnessString.c_str(), brightnessString.length());
+            this->m_brightness.write(this->m_brightnessValues[this->m_brightnessIndex]);
         }
 
-        void stopRendering() {
-            pid_t child = fork();
-
-            if (!child)
-                execlp("fuser", "fuser", "-k", "-STOP", "/dev/fb0", nullptr);
-
+        void initialize(pwswd::dev::HolderResolver *holderResolver) {
+            this->m_holderResolver = holderResolver;
+        }
 
-            int status = 0;
-            waitpid(child, &status, 0);
+        void stopRendering() {
+            HolderResolver::signal(this->m_holderResolver->findHolders(this->m_framebufferPath), SIGSTOP);
         }
 
         void continueRendering() {
-            pid_t child = fork();
-
-            if (!child)
-                execlp("fuser", "fuser", "-k", "-CONT", "/dev/fb0", nullptr);
-
-            int status = 0;
-            waitpid(child, &status, 0);        
+            // The applications stopped before still hold the framebuffer, so only they need to be checked again
+            HolderResolver::signal(this->m_holderResolver->findCachedHolders(this->m_framebufferPath), SIGCONT);
         }
 
+        // Sharpness and brightness steps only get staged, call flush once all pending input has been handled
         void increaseSharpness() {
             if (this->m_sharpness == 0)
                 return;
 
             this->m_sharpness--;
 
-            auto sharpnessString = std::to_string(this->m_sharpness);
-
-            write(this->m_sharpnessUpscalingfd, sharpnessString.c_str(), sharpnessString.length());
-            write(this->m_sharpnessDownscalingfd, sharpnessString.c_str(), sharpnessString.length());
+            this->stageSharpness();
         }
 
         void decreaseSharpness() {
-            if (this->m_sharpness >= 32)
+            if (this->m_sharpness >= MaxSharpness)
                 return;
 
             this->m_sharpness++;
 
-            auto sharpnessString = std::to_string(this->m_sharpness);
-
-            write(this->m_sharpnessUpscalingfd, sharpnessString.c_str(), sharpnessString.length());
-            write(this->m_sharpnessDownscalingfd, sharpnessString.c_str(), sharpnessString.length());
+            this->stageSharpness();
         }
 
         void increaseBrightness() {
-            if (this->m_brightnessIndex >= sizeof(BrightnessValues))
+            if (this->m_brightnessIndex >= this->m_brightnessValues.size() - 1)
                 return;
 
             this->m_brightnessIndex++;
 
-            this->setBrightness(BrightnessValues[this->m_brightnessIndex]);
+            this->m_brightness.stage(this->m_brightnessValues[this->m_brightnessIndex]);
         }
 
         void decreaseBrightness() {
@@ -123,20 +105,61 @@ namespace pwswd::dev {
 
             this->m_brightnessIndex--;
 
-            this->setBrightness(BrightnessValues[this->m_brightnessIndex]);
+            this->m_brightness.stage(this->m_brightnessValues[this->m_brightnessIndex]);
         }
 
         std::uint8_t getBrightness() {
-            char buffer[10] = { 0 };
-            read(this->m_brightnessfd, buffer, 9);
-
-            return atoi(buffer);
+            return this->m_brightness.readInteger();
         }
 
         void setBrightness(std::uint8_t brightness) {
-            auto brightnessString = std::to_string(brightness);
+            this->m_brightness.write(brightness);
+        }
+
+        // Writes everything that changed since the last flush
+        void flush() {
+            this->m_sharpnessUpscaling.flush();
+            this->m_sharpnessDownscaling.flush();
+            this->m_keepAspectRatio.flush();
+            this->m_brightness.flush();
+
+            if (this->m_integerScaling != nullptr)
+                this->m_integerScaling->flush();
+        }
 
-            write(this->m_brightnessfd, brightnessString.c_str(), brightnessString.length());
+        // Replaces the brightness steps, they have to be sorted and there have to be at least two. The current brightness stays as it is until the next step
+        void setBrightnessValues(const std::vector<std::uint8_t> &values) {
+            if (values.size() < 2 || values == this->m_brightnessValues)
+                return;
+
+            const auto currBrightnessValue = this->m_brightnessValues[this->m_brightnessIndex];
+
+            this->m_brightnessValues = values;
+            this->m_brightnessIndex = this->findBrightnessIndex(currBrightnessValue);
+        }
+
+        // Number of values that actually reached sysfs so far
+        [[nodiscard]] std::uint64_t getWriteCount() const {
+            std::uint64_t count = this->m_blanking.getWriteCount() + this->m_sharpnessUpscaling.getWriteCount() + this->m_sharpnessDownscaling.getWriteCount() +
+                                  this->m_keepAspectRatio.getWriteCount() + this->m_brightness.getWriteCount();
+
+            if (this->m_integerScaling != nullptr)
+                count += this->m_integerScaling->getWriteCount();
+
+            return count;
+        }
+
+        // Sharpness in percent, lower register values mean a sharper picture
+        [[nodiscard]] std::uint8_t getSharpnessLevel() {
+            return ((MaxSharpness - std::min(this->m_sharpness, MaxSharpness)) * 100) / MaxSharpness;
+        }
+
+        [[nodiscard]] std::uint8_t getBrightnessLevel() {
+            return (this->m_brightnessIndex * 100) / (this->m_brightnessValues.size() - 1);
+        }
+
+        [[nodiscard]] std::uint8_t getDisplayStyle() {
+            return this->m_displayStyle;
         }
 
         void toggleDisplayStyle() {
@@ -145,23 +168,56 @@ namespace pwswd::dev {
             else
                 this->m_displayStyle++;
 
-            write(this->m_keepAspectRatiofd, (this->m_displayStyle & 0b01) ? "Y" : "N", 1);
-            write(this->m_integerScalingfd, (this->m_displayStyle & 0b10) ? "Y" : "N", 1);
+            this->m_keepAspectRatio.stage((this->m_displayStyle & 0b01) ? "Y" : "N");
+
+            if (this->m_integerScaling != nullptr)
+                this->m_integerScaling->stage((this->m_displayStyle & 0b10) ? "Y" : "N");
         }
 
     private:
-        static constexpr std::uint8_t BrightnessValues[] = { 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 19, 20, 25, 30, 35, 40, 45, 50, 80, 100, 150, 255 };
+        static constexpr auto FramebufferPath = "/dev/fb0";
+
+        static constexpr auto BlankingPath = "/class/graphics/fb0/blank";
+        static constexpr auto SharpnessUpscalingPath = "/devices/platform/jz-lcd.0/sharpness_upscaling";
+        static constexpr auto SharpnessDownscalingPath = "/devices/platform/jz-lcd.0/sharpness_downscaling";
+        static constexpr auto KeepAspectRatioPath = "/devices/platform/jz-lcd.0/keep_aspect_ratio";
+        static constexpr auto IntegerScalingPath = "/devices/platform/jz-lcd.0/integer_scaling";
+        static constexpr auto BrightnessPath = "/devices/platform/pwm-backlight/backlight/pwm-backlight/brightness";
+
+        static constexpr std::uint8_t MaxSharpness = 32;
+        static constexpr std::uint8_t DefaultBrightness = 100;
+
+        std::string m_framebufferPath;
+
+        SysfsAttribute m_blanking;
+        SysfsAttribute m_sharpnessUpscaling;
+        SysfsAttribute m_sharpnessDownscaling;
+        SysfsAttribute m_keepAspectRatio;
+        SysfsAttribute m_brightness;
+        std::unique_ptr<SysfsAttribute> m_integerScaling;
 
-        int m_blankingfd;
-        int m_sharpnessUpscalingfd;
-        int m_sharpnessDownscalingfd;
-        int m_keepAspectRatiofd;
-        int m_integerScalingfd;
-        int m_brightnessfd;
+        pwswd::dev::HolderResolver *m_holderResolver = nullptr;
 
         std::uint8_t m_sharpness;
         std::uint8_t m_displayStyle;
+        std::vector<std::uint8_t> m_brightnessValues { DefaultBrightnessValues.begin(), DefaultBrightnessValues.end() };
         std::uint8_t m_brightnessIndex;
+
+        // Upscaling and downscaling are separate settings in the driver, both always get the same value
+        void stageSharpness() {
+            this->m_sharpnessUpscaling.stage(this->m_sharpness);
+            this->m_sharpnessDownscaling.stage(this->m_sharpness);
+        }
+
+        // First step that's at least as bright as the given value
+        [[nodiscard]] std::uint8_t findBrightnessIndex(std::uint8_t value) const {
+            for (std::uint8_t i = 0; i < this->m_brightnessValues.size(); i++) {
+                if (this->m_brightnessValues[i] >= value)
+                    return i;
+            }
+
+            return this->m_brightnessValues.size() - 1;
+        }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/vfs.h>
+
+namespace pwswd::dev {
+
+    /**
+     * Single value file in sysfs. Every access goes to offset 0, so the fd can stay open for
+     * the daemon's whole lifetime. The last value read or written is cached and writing the
+     * same value again doesn't reach the kernel. Values can also be staged and get written
+     * once on the next flush, so a burst of key repeats turns into a single write.
+     */
+    class SysfsAttribute {
+    public:
+        explicit SysfsAttribute(const std::string &path) {
+            this->m_fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+
+            if (this->m_fd == -1)
+                throw std::runtime_error("Failed to open " + path);
+
+            // Regular files keep their old contents past the end of a shorter value, sysfs attributes don't
+            struct statfs fileSystem;
+            this->m_truncate = fstatfs(this->m_fd, &fileSystem) == 0 && fileSystem.f_type != SysfsMagic;
+        }
+
+        ~SysfsAttribute() {
+            ::close(this->m_fd);
+        }
+
+        SysfsAttribute(const SysfsAttribute&) = delete;
+        SysfsAttribute& operator=(const SysfsAttribute&) = delete;
+
+        // Reads the current value from the kernel without the trailing newline
+        const std::string& read() {
+            char buffer[64];
+            ssize_t size = pread(this->m_fd, buffer, sizeof(buffer) - 1, 0);
+
+            if (size < 0)
+                size = 0;
+
+            while (size > 0 && (buffer[size - 1] == '\n' || buffer[size - 1] == ' '))
+                size--;
+
+            this->m_value.assign(buffer, size);
+            this->m_valid = true;
+
+            return this->m_value;
+        }
+
+        [[nodiscard]] std::int32_t readInteger() {
+            return std::strtol(this->read().c_str(), nullptr, 10);
+        }
+
+        // Writes a value right away, dropping anything that's staged
+        bool write(std::string_view value) {
+            this->m_staged.reset();
+
+            if (this->m_valid && this->m_value == value)
+                return true;
+
+            if (pwrite(this->m_fd, value.data(), value.size(), 0) != ssize_t(value.size())) {
+                // Whatever's in the file now is unknown, don't skip the next write
+                this->m_valid = false;
+                return false;
+            }
+
+            if (this->m_truncate)
+                ftruncate(this->m_fd, value.size());
+
+            this->m_writeCount++;
+            this->m_value = value;
+            this->m_valid = true;
+
+            return true;
+        }
+
+        bool write(std::int32_t value) {
+            return this->write(std::to_string(value));
+        }
+
+        // Remembers a value to be written on the next flush, replacing anything staged before
+        void stage(std::string_view value) {
+            this->m_staged = std::string(value);
+        }
+
+        void stage(std::int32_t value) {
+            this->stage(std::to_string(value));
+        }
+
+        bool flush() {
+            if (!this->m_staged.has_value())
+                return true;
+
+            auto value = std::move(*this->m_staged);
+            return this->write(value);
+        }
+
+        [[nodiscard]] bool isStaged() const {
+            return this->m_staged.has_value();
+        }
+
+        [[nodiscard]] std::uint64_t getWriteCount() const {
+            return this->m_writeCount;
+        }
+
+    private:
+        static constexpr decltype(statfs::f_type) SysfsMagic = 0x6265'6572;
+
+        int m_fd;
+        bool m_truncate;
+
+        std::string m_value;
+        bool m_valid = false;
+
+        std::optional<std::string> m_staged;
+
+        std::uint64_t m_writeCount = 0;
+    };
+
+}
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <stdexcept>
 
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <cstring>
 
 #include "events.hpp"
@@ -59,6 +61,47 @@ namespace pwswd::dev {
             write(this->m_uinputfd, &data, sizeof(T));
         }
 
+        /**
+         * Adds an event to the current frame. Relative axis events without any movement
+         * are dropped since they wouldn't change anything for readers of the device.
+         */
+        void queue(const pwswd::InputEvent &event) {
+            if (event.type == static_cast<std::uint16_t>(pwswd::EventType::RelativeAxes) && event.value == 0)
+                return;
+
+            if (this->m_frameSize == this->m_frame.size())
+                this->flush();
+
+            this->m_frame[this->m_frameSize++] = event;
+        }
+
+        // Writes all queued events and the terminating SYN_REPORT with a single syscall, empty frames aren't sent at all
+        void flush() {
+            if (this->m_frameSize == 0)
+                return;
+
+            auto syncEvent = pwswd::createSyncEvent();
+
+            iovec vectors[2] = {
+                { this->m_frame.data(), this->m_frameSize * sizeof(pwswd::InputEvent) },
+                { &syncEvent, sizeof(pwswd::InputEvent) }
+            };
+
+            writev(this->m_uinputfd, vectors, 2);
+
+            this->m_frameCount++;
+            this->m_eventCount += this->m_frameSize;
+            this->m_frameSize = 0;
+        }
+
+        [[nodiscard]] std::uint64_t getFrameCount() const {
+            return this->m_frameCount;
+        }
+
+        [[nodiscard]] std::uint64_t getEventCount() const {
+            return this->m_eventCount;
+        }
+
         void setEventFilterBit(pwswd::EventType type) {
             if (ioctl(this->m_uinputfd, IoCtlCommandUInputSetEventBit, std::uint32_t(type)))
                 throw std::runtime_error("Failed to set event bit!");
@@ -80,12 +123,19 @@ namespace pwswd::dev {
         }
 
     private:
-        static constexpr std::uint32_t IoCtlCommandUInputSetEventBit = 0x8004'5564;
-        static constexpr std::uint32_t IoCtlCommandUInputSetKeyBit = 0x8004'5565;
-        static constexpr std::uint32_t IoCtlCommandUInputSetRelativeBit = 0x8004'5566;
-        static constexpr std::uint32_t IoCtlCommandUInputDeviceCreate = 0x2000'5501;
+        static constexpr std::uint32_t IoCtlCommandUInputSetEventBit = _IOW('U', 100, int);
+        static constexpr std::uint32_t IoCtlCommandUInputSetKeyBit = _IOW('U', 101, int);
+        static constexpr std::uint32_t IoCtlCommandUInputSetRelativeBit = _IOW('U', 102, int);
+        static constexpr std::uint32_t IoCtlCommandUInputDeviceCreate = _IO('U', 1);
+
+        static constexpr std::size_t MaxFrameSize = 16;
 
         int m_uinputfd;
+
+        std::array<pwswd::InputEvent, MaxFrameSize> m_frame;
+        std::size_t m_frameSize = 0;
+
+        std::uint64_t m_frameCount = 0, m_eventCount = 0;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace pwswd {
+
+    [[nodiscard]] inline std::uint64_t getMonotonicTime() {
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+
+        return std::uint64_t(time.tv_sec) * 1'000'000 + time.tv_nsec / 1000;
+    }
+
+    // CPU time the calling thread spent so far in microseconds
+    [[nodiscard]] inline std::uint64_t getThreadCpuTime() {
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+        return std::uint64_t(time.tv_sec) * 1'000'000 + time.tv_nsec / 1000;
+    }
+
+    struct SourceStatistics {
+        std::uint64_t wakeups;
+        std::uint64_t events;
+        std::uint64_t time;
+        std::uint64_t cpuTime;
+    };
+
+    /**
+     * Waits on any number of fds and runs their callback once they become readable. Every fd is
+     * accounted to a named source, sources sharing a name share their statistics. Callbacks can
+     * report how many events they handled through countEvents.
+     */
+    class EventLoop {
+    public:
+        using Callback = std::function<void()>;
+
+        EventLoop() {
+            this->m_epollfd = epoll_create1(EPOLL_CLOEXEC);
+
+            if (this->m_epollfd == -1)
+                throw std::runtime_error("Failed to create epoll!");
+        }
+
+        ~EventLoop() {
+            close(this->m_epollfd);
+        }
+
+        void add(int fd, const std::string &name, Callback callback) {
+            epoll_event eventData = { 0 };
+            eventData.events = EPOLLIN;
+            eventData.data.fd = fd;
+
+            if (epoll_ctl(this->m_epollfd, EPOLL_CTL_ADD, fd, &eventData) == -1)
+                throw std::runtime_error("Failed to add fd to event loop!");
+
+            this->m_sources[fd] = { std::move(callback), &this->m_statistics[name] };
+        }
+
+        // Statistics of the fd's source are kept around
+        void remove(int fd) {
+            epoll_ctl(this->m_epollfd, EPOLL_CTL_DEL, fd, nullptr);
+            this->m_sources.erase(fd);
+        }
+
+        void runOnce(std::int32_t timeout = -1) {
+            epoll_event events[MaxEventsPerWakeup];
+
+            int count = epoll_wait(this->m_epollfd, events, MaxEventsPerWakeup, timeout);
+            if (count <= 0)
+                return;
+
+            this->m_wakeupCount++;
+
+            for (int i = 0; i < count; i++) {
+                // Callbacks may remove other fds, so look every one of them up again
+                auto source = this->m_sources.find(events[i].data.fd);
+                if (source == this->m_sources.end())
+                    continue;
+
+                // The callback may remove its own fd, only keep the statistics around
+                auto statistics = source->second.statistics;
+                this->m_currentSource = statistics;
+
+                const auto startTime = getMonotonicTime();
+                const auto startCpuTime = getThreadCpuTime();
+
+                source->second.callback();
+
+                statistics->wakeups++;
+                statistics->time += getMonotonicTime() - startTime;
+                statistics->cpuTime += getThreadCpuTime() - startCpuTime;
+                this->m_currentSource = nullptr;
+            }
+        }
+
+        // Adds to the number of events handled by the source whose callback is currently running
+        void countEvents(std::uint64_t count) {
+            if (this->m_currentSource != nullptr)
+                this->m_currentSource->events += count;
+        }
+
+        [[noreturn]] void run() {
+            while (true)
+                this->runOnce();
+        }
+
+        [[nodiscard]] std::uint64_t getWakeupCount() const {
+            return this->m_wakeupCount;
+        }
+
+        [[nodiscard]] const std::map<std::string, SourceStatistics>& getStatistics() const {
+            return this->m_statistics;
+        }
+
+    private:
+        static constexpr std::uint32_t MaxEventsPerWakeup = 8;
+
+        struct Source {
+            Callback callback;
+            SourceStatistics *statistics;
+        };
+
+        int m_epollfd;
+        std::map<int, Source> m_sources;
+
+        // Nodes of a map never move, so sources can point right at their statistics
+        std::map<std::string, SourceStatistics> m_statistics;
+        SourceStatistics *m_currentSource = nullptr;
+
+        std::uint64_t m_wakeupCount = 0;
+    };
+
+    class Timer {
+    public:
+        Timer() {
+            this->m_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+            if (this->m_timerfd == -1)
+                throw std::runtime_error("Failed to create timer!");
+        }
+
+        ~Timer() {
+            close(this->m_timerfd);
+        }
+
+        void arm(std::uint32_t periodUs) {
+            this->set(periodUs, periodUs);
+        }
+
+        void armOnce(std::uint32_t delayUs) {
+            this->set(delayUs, 0);
+        }
+
+        void disarm() {
+            this->set(0, 0);
+        }
+
+        // Expires once at the given CLOCK_MONOTONIC time in microseconds, immediately if it already passed
+        void armAt(std::uint64_t timeUs) {
+            itimerspec spec = { 0 };
+            spec.it_value.tv_sec = timeUs / 1'000'000;
+            spec.it_value.tv_nsec = (timeUs % 1'000'000) * 1000;
+
+            // A zero value would disarm the timer instead
+            if (timeUs == 0)
+                spec.it_value.tv_nsec = 1;
+
+            timerfd_settime(this->m_timerfd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+            this->m_armed = true;
+            this->m_periodic = false;
+        }
+
+        [[nodiscard]] bool isArmed() const {
+            return this->m_armed;
+        }
+
+        std::uint64_t acknowledge() {
+            std::uint64_t expirations = 0;
+            read(this->m_timerfd, &expirations, sizeof(expirations));
+
+            // One-shot timers disarm themselves once they expired
+            if (!this->m_periodic)
+                this->m_armed = false;
+
+            return expirations;
+        }
+
+        [[nodiscard]] int getFd() const {
+            return this->m_timerfd;
+        }
+
+    private:
+        int m_timerfd;
+        bool m_armed = false;
+        bool m_periodic = false;
+
+        void set(std::uint32_t delayUs, std::uint32_t periodUs) {
+            itimerspec spec = { 0 };
+            spec.it_value.tv_sec = delayUs / 1'000'000;
+            spec.it_value.tv_nsec = (delayUs % 1'000'000) * 1000;
+            spec.it_interval.tv_sec = periodUs / 1'000'000;
+            spec.it_interval.tv_nsec = (periodUs % 1'000'000) * 1000;
+
+            timerfd_settime(this->m_timerfd, 0, &spec, nullptr);
+
+            this->m_armed = periodUs != 0 || delayUs != 0;
+            this->m_periodic = periodUs != 0;
+        }
+    };
+
+    class Notifier {
+    public:
+        Notifier() {
+            this->m_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            if (this->m_eventfd == -1)
+                throw std::runtime_error("Failed to create eventfd!");
+        }
+
+        ~Notifier() {
+            close(this->m_eventfd);
+        }
+
+        void notify() {
+            std::uint64_t value = 1;
+            write(this->m_eventfd, &value, sizeof(value));
+        }
+
+        std::uint64_t acknowledge() {
+            std::uint64_t value = 0;
+            read(this->m_eventfd, &value, sizeof(value));
+
+            return value;
+        }
+
+        [[nodiscard]] int getFd() const {
+            return this->m_eventfd;
+        }
+
+    private:
+        int m_eventfd;
+    };
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <sys/time.h>
 
@@ -11,12 +12,12 @@ namespace pwswd {
     static constexpr std::uint16_t JoyStickXAxisCenter = 1730;
     static constexpr std::uint16_t JoyStickYAxisCenter = 1620;
     static constexpr std::uint16_t JoyStickDeadZone = 350;
-    static constexpr std::uint16_t JoyStickSpeedDownscaler = 200;
 
     enum class EventType {
         Synchronization     = 0,
         Buttons             = 1,
-        RelativeAxes        = 2
+        RelativeAxes        = 2,
+        AbsoluteAxes        = 3
     };
 
     enum class SynchronizationEvent {
@@ -77,6 +78,25 @@ namespace pwswd {
         std::int32_t value;
     };
 
+    struct InputAbsInfo {
+        std::int32_t value;
+        std::int32_t minimum;
+        std::int32_t maximum;
+        std::int32_t fuzz;
+        std::int32_t flat;
+        std::int32_t resolution;
+    };
+
+    struct InputFrame {
+        const InputEvent *events;
+        std::size_t count;
+
+        [[nodiscard]] const InputEvent* begin() const { return this->events; }
+        [[nodiscard]] const InputEvent* end() const { return this->events + this->count; }
+        [[nodiscard]] std::size_t size() const { return this->count; }
+        [[nodiscard]] bool empty() const { return this->count == 0; }
+    };
+
     enum class MouseMode {
         Deactivated,
         LeftJoyStick,
@@ -109,6 +129,17 @@ namespace pwswd {
         return event;        
     }
 
+    static inline InputEvent createAbsoluteAxisInputEvent(RelativeAxis axis, std::int32_t value) {
+        pwswd::InputEvent event;
+
+        gettimeofday(&event.time, nullptr);
+        event.type = static_cast<std::uint16_t>(EventType::AbsoluteAxes);
+        event.code = static_cast<std::uint16_t>(axis);
+        event.value = value;
+
+        return event;
+    }
+
     static inline InputEvent createSyncEvent() {
         pwswd::InputEvent event;
 
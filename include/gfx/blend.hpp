@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "pixel_format.hpp"
+#include "span_fill.hpp"
+#include "surface.hpp"
+
+namespace pwswd::gfx {
+
+    /**
+     * Alpha blending of overlay pixels over the game's pixels. Colors are in the surface's
+     * native format and alpha goes from 0 (only the background) to 255 (only the overlay).
+     * The background may be a different buffer than the destination, e.g. the compositor's
+     * backup of the game's pixels, which keeps blending the same frame twice idempotent.
+     */
+    namespace blend {
+
+        template<typename Format>
+        constexpr bool IsRGB565 = std::is_same_v<Format, RGB565> || std::is_same_v<Format, BGR565>;
+
+        template<typename Format>
+        constexpr bool IsXRGB8888 = std::is_same_v<Format, XRGB8888> || std::is_same_v<Format, XBGR8888>;
+
+        /*
+         * 565 pixels get split into two groups of fields with enough space between them that a
+         * multiplication with a 5 bit alpha doesn't spill into the next field. That way the three
+         * channels of two pixels in a word get blended with two multiplications per operand.
+         */
+        constexpr std::uint32_t RGB565EvenFields = 0x07E0'F81F;
+        constexpr std::uint32_t RGB565OddFields  = 0x07C0'F83F;
+
+        // Weights with a power of two as total, so the division turns into a shift
+        [[nodiscard]] constexpr std::uint32_t toAlpha5(std::uint8_t alpha) {
+            return (std::uint32_t(alpha) + 4) >> 3;
+        }
+
+        [[nodiscard]] constexpr std::uint32_t toAlpha8(std::uint8_t alpha) {
+            return std::uint32_t(alpha) + (alpha >> 7);
+        }
+
+        [[nodiscard]] constexpr std::uint32_t blendRGB565Pair(std::uint32_t dst, std::uint32_t srcEven, std::uint32_t srcOdd, std::uint32_t alpha5) {
+            const std::uint32_t even = ((dst & RGB565EvenFields) * (32 - alpha5) + srcEven) >> 5;
+            const std::uint32_t odd  = (((dst >> 5) & RGB565OddFields) * (32 - alpha5) + srcOdd) >> 5;
+
+            return (even & RGB565EvenFields) | ((odd & RGB565OddFields) << 5);
+        }
+
+        // Single pixel, spread over a whole word with the same gaps as above
+        [[nodiscard]] constexpr std::uint32_t blendRGB565(std::uint32_t dst, std::uint32_t src, std::uint32_t alpha5) {
+            const std::uint32_t dstSpread = (dst | (dst << 16)) & RGB565EvenFields;
+            const std::uint32_t srcSpread = (src | (src << 16)) & RGB565EvenFields;
+            const std::uint32_t result = ((dstSpread * (32 - alpha5) + srcSpread * alpha5) >> 5) & RGB565EvenFields;
+
+            return (result | (result >> 16)) & 0xFFFF;
+        }
+
+        // Red and blue of an 8888 pixel in one multiplication, green in another. The padding byte is kept from dst
+        [[nodiscard]] constexpr std::uint32_t blendXRGB8888(std::uint32_t dst, std::uint32_t src, std::uint32_t alpha8) {
+            const std::uint32_t redBlue = (((dst & 0x00FF'00FF) * (256 - alpha8) + (src & 0x00FF'00FF) * alpha8) >> 8) & 0x00FF'00FF;
+            const std::uint32_t green   = (((dst & 0x0000'FF00) * (256 - alpha8) + (src & 0x0000'FF00) * alpha8) >> 8) & 0x0000'FF00;
+
+            return (dst & 0xFF00'0000) | redBlue | green;
+        }
+
+        template<typename Format>
+        [[nodiscard]] inline std::uint32_t loadPixel(const std::uint8_t *pixel) {
+            std::uint32_t value = 0;
+            std::memcpy(&value, pixel, Format::BytesPerPixel);
+
+            return value;
+        }
+
+        template<typename Format>
+        inline void storePixel(std::uint8_t *pixel, std::uint32_t value) {
+            std::memcpy(pixel, &value, Format::BytesPerPixel);
+        }
+
+        template<typename Format>
+        [[nodiscard]] inline std::uint32_t blendPixel(std::uint32_t dst, std::uint32_t src, std::uint8_t alpha) {
+            if constexpr (IsRGB565<Format>)
+                return blendRGB565(dst, src, toAlpha5(alpha));
+            else if constexpr (IsXRGB8888<Format>)
+                return blendXRGB8888(dst, src, toAlpha8(alpha));
+            else
+                return Format::blend(dst, src, alpha);
+        }
+
+    }
+
+    /**
+     * Blends count pixels of background with one color at a constant alpha and writes them to dst.
+     * dst and background may be the same span.
+     */
+    template<typename Format>
+    inline void blendSpan(std::uint8_t *dst, const std::uint8_t *background, std::uint32_t count, std::uint32_t color, std::uint8_t alpha) {
+        constexpr auto bpp = Format::BytesPerPixel;
+
+        if (alpha == 0xFF) {
+            fillSpan<bpp>(dst, count, color);
+            return;
+        }
+
+        if constexpr (blend::IsRGB565<Format>) {
+            const std::uint32_t alpha5 = blend::toAlpha5(alpha);
+
+            // Head, single pixel until the destination is word aligned
+            if (count > 0 && (reinterpret_cast<std::uintptr_t>(dst) & 0b10)) {
+                blend::storePixel<Format>(dst, blend::blendRGB565(blend::loadPixel<Format>(background), color, alpha5));
+                dst += 2;
+                background += 2;
+                count--;
+            }
+
+            // Body, the color's part of the sum is the same for every pair of pixels
+            const std::uint32_t pair = (color & 0xFFFF) * 0x0001'0001;
+            const std::uint32_t srcEven = (pair & blend::RGB565EvenFields) * alpha5;
+            const std::uint32_t srcOdd = ((pair >> 5) & blend::RGB565OddFields) * alpha5;
+
+            auto words = reinterpret_cast<Word*>(dst);
+            for (; count >= 2; count -= 2, background += 4) {
+                std::uint32_t pixels;
+                std::memcpy(&pixels, background, sizeof(pixels));
+
+                *words++ = blend::blendRGB565Pair(pixels, srcEven, srcOdd, alpha5);
+            }
+
+            // Tail, remaining odd pixel
+            if (count)
+                blend::storePixel<Format>(reinterpret_cast<std::uint8_t*>(words), blend::blendRGB565(blend::loadPixel<Format>(background), color, alpha5));
+        } else {
+            for (; count > 0; count--, dst += bpp, background += bpp)
+                blend::storePixel<Format>(dst, blend::blendPixel<Format>(blend::loadPixel<Format>(background), color, alpha));
+        }
+    }
+
+    /**
+     * Blends count pixels of src with their own alpha values over background and writes them to dst.
+     * Fully opaque and fully transparent runs are copied instead of blended.
+     */
+    template<typename Format>
+    inline void blendSpan(std::uint8_t *dst, const std::uint8_t *background, const std::uint8_t *src, const std::uint8_t *alpha, std::uint32_t count) {
+        constexpr auto bpp = Format::BytesPerPixel;
+
+        for (std::uint32_t pixel = 0; pixel < count;) {
+            const std::uint8_t runAlpha = alpha[pixel];
+
+            if (runAlpha == 0xFF || runAlpha == 0x00) {
+                std::uint32_t runEnd = pixel + 1;
+                while (runEnd < count && alpha[runEnd] == runAlpha)
+                    runEnd++;
+
+                const std::uint8_t *runSource = runAlpha == 0xFF ? src : background;
+                if (runSource != dst)
+                    std::memmove(dst + pixel * bpp, runSource + pixel * bpp, (runEnd - pixel) * bpp);
+
+                pixel = runEnd;
+                continue;
+            }
+
+            blend::storePixel<Format>(dst + pixel * bpp, blend::blendPixel<Format>(blend::loadPixel<Format>(background + pixel * bpp), blend::loadPixel<Format>(src + pixel * bpp), runAlpha));
+            pixel++;
+        }
+    }
+
+    // Draws a rect with the alpha value of the 0xRRGGBBAA color over what's already on the surface
+    template<typename Format>
+    inline void blendRect(const Surface &surface, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t color) {
+        const std::uint8_t alpha = color & 0xFF;
+        if (alpha == 0x00)
+            return;
+
+        auto area = surface.getSubSurface(x, y, w, h);
+        const auto encoded = Format::encode(color);
+
+        for (std::uint32_t row = 0; row < area.height; row++) {
+            auto line = area.data + row * area.pitch;
+            blendSpan<Format>(line, line, area.width, encoded, alpha);
+        }
+    }
+
+    /**
+     * Blends src with the per pixel alpha values in the 1 byte per pixel alpha surface over
+     * background into dst. All surfaces are clipped to the smallest one.
+     */
+    template<typename Format>
+    inline void blendBlit(const Surface &dst, const Surface &background, const Surface &src, const Surface &alpha) {
+        if (dst.bytesPerPixel != Format::BytesPerPixel || background.bytesPerPixel != Format::BytesPerPixel || src.bytesPerPixel != Format::BytesPerPixel || alpha.bytesPerPixel != 1)
+            return;
+
+        const std::uint32_t width = std::min({ dst.width, background.width, src.width, alpha.width });
+        const std::uint32_t height = std::min({ dst.height, background.height, src.height, alpha.height });
+
+        for (std::uint32_t row = 0; row < height; row++)
+            blendSpan<Format>(dst.data + row * dst.pitch, background.data + row * background.pitch, src.data + row * src.pitch, alpha.data + row * alpha.pitch, width);
+    }
+
+    static_assert(blend::blendRGB565(0x0000, 0xFFFF, 32) == 0xFFFF);
+    static_assert(blend::blendRGB565(0xF800, 0x001F, 0) == 0xF800);
+    static_assert(blend::blendRGB565Pair(0xFFFF'0000, (0x0000'FFFF & blend::RGB565EvenFields) * 32, ((0x0000'FFFF >> 5) & blend::RGB565OddFields) * 32, 32) == 0x0000'FFFF);
+    static_assert(blend::blendXRGB8888(0xFF00'0000, 0x00FF'FFFF, 256) == 0xFFFF'FFFF);
+
+}
\ No newline at end of file
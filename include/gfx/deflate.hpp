@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace pwswd::gfx {
+
+    constexpr std::array<std::uint32_t, 256> Crc32Table = [] {
+        std::array<std::uint32_t, 256> table = { };
+
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t value = i;
+            for (std::uint8_t bit = 0; bit < 8; bit++)
+                value = (value & 1) ? (0xEDB8'8320 ^ (value >> 1)) : (value >> 1);
+
+            table[i] = value;
+        }
+
+        return table;
+    }();
+
+    // Continues a CRC-32 over more data, start with 0
+    [[nodiscard]] inline std::uint32_t crc32(std::uint32_t crc, const std::uint8_t *data, std::size_t size) {
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; i++)
+            crc = Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+        return ~crc;
+    }
+
+    /**
+     * zlib stream compressor that works on data as it comes in, so an image can be compressed
+     * one row at a time. Uses greedy LZ77 matching with a single candidate per hash over a
+     * fixed window and the fixed Huffman codes, all in one deflate block. Doesn't compress as
+     * well as zlib, but memory use is fixed and there's no dependency to cross compile.
+     */
+    class DeflateStream {
+    public:
+        using Output = std::function<void(const std::uint8_t *data, std::size_t size)>;
+
+        explicit DeflateStream(Output output) : m_output(std::move(output)) {
+            this->m_window.resize(WindowSize * 2);
+            this->m_head.resize(1 << HashBits);
+
+            this->reset();
+        }
+
+        // Starts a new stream
+        void reset() {
+            std::fill(this->m_head.begin(), this->m_head.end(), -1);
+            this->m_windowEnd = 0;
+            this->m_position = 0;
+            this->m_adlerA = 1;
+            this->m_adlerB = 0;
+            this->m_bitBuffer = 0;
+            this->m_bitCount = 0;
+            this->m_outputSize = 0;
+
+            // zlib header for a 32K window without preset dictionary, then the only block, marked as final and using fixed codes
+            this->writeBits(0x78, 8);
+            this->writeBits(0x01, 8);
+            this->writeBits(1, 1);
+            this->writeBits(1, 2);
+        }
+
+        void write(const std::uint8_t *data, std::size_t size) {
+            this->updateAdler(data, size);
+
+            while (size > 0) {
+                // Once the buffer is full, drop the half that's out of reach for matches
+                if (this->m_windowEnd == this->m_window.size())
+                    this->slideWindow();
+
+                std::size_t chunkSize = std::min(size, this->m_window.size() - this->m_windowEnd);
+                std::memcpy(&this->m_window[this->m_windowEnd], data, chunkSize);
+                this->m_windowEnd += chunkSize;
+                data += chunkSize;
+                size -= chunkSize;
+
+                this->compress(false);
+            }
+        }
+
+        // Compresses everything that's left and ends the stream
+        void finish() {
+            this->compress(true);
+            this->writeLiteral(256);
+
+            if (this->m_bitCount > 0)
+                this->writeBits(0, 8 - this->m_bitCount);
+
+            std::uint32_t adler = (this->m_adlerB << 16) | this->m_adlerA;
+            for (std::int8_t shift = 24; shift >= 0; shift -= 8)
+                this->writeBits((adler >> shift) & 0xFF, 8);
+
+            this->flushOutput();
+        }
+
+    private:
+        static constexpr std::size_t WindowSize = 32768;
+        static constexpr std::size_t MinMatch = 3;
+        static constexpr std::size_t MaxMatch = 258;
+        static constexpr std::uint8_t HashBits = 13;
+        static constexpr std::size_t OutputBufferSize = 4096;
+
+        static constexpr std::uint16_t LengthBase[]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static constexpr std::uint8_t LengthExtra[]  = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static constexpr std::uint16_t DistanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static constexpr std::uint8_t DistanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        Output m_output;
+
+        // Two windows worth of input, matches may reach one window back from the current position
+        std::vector<std::uint8_t> m_window;
+        std::size_t m_windowEnd, m_position;
+
+        // Most recent position of every 3 byte hash, -1 if there's none in reach
+        std::vector<std::int32_t> m_head;
+
+        std::uint32_t m_adlerA, m_adlerB;
+
+        std::uint32_t m_bitBuffer;
+        std::uint8_t m_bitCount;
+
+        std::array<std::uint8_t, OutputBufferSize> m_outputBuffer;
+        std::size_t m_outputSize;
+
+        void updateAdler(const std::uint8_t *data, std::size_t size) {
+            // 5552 bytes is the most that can be summed up before the 32 bit sums could overflow
+            while (size > 0) {
+                std::size_t chunkSize = std::min<std::size_t>(size, 5552);
+
+                for (std::size_t i = 0; i < chunkSize; i++) {
+                    this->m_adlerA += data[i];
+                    this->m_adlerB += this->m_adlerA;
+                }
+
+                this->m_adlerA %= 65521;
+                this->m_adlerB %= 65521;
+                data += chunkSize;
+                size -= chunkSize;
+            }
+        }
+
+        void slideWindow() {
+            std::memmove(&this->m_window[0], &this->m_window[WindowSize], WindowSize);
+            this->m_windowEnd -= WindowSize;
+            this->m_position -= WindowSize;
+
+            for (auto &position : this->m_head)
+                position = position >= std::int32_t(WindowSize) ? position - std::int32_t(WindowSize) : -1;
+        }
+
+        [[nodiscard]] std::uint32_t hash(std::size_t position) const {
+            const std::uint8_t *bytes = &this->m_window[position];
+            return ((std::uint32_t(bytes[0]) << 16 | std::uint32_t(bytes[1]) << 8 | bytes[2]) * 2654435761U) >> (32 - HashBits);
+        }
+
+        void insertHash(std::size_t position) {
+            if (position + MinMatch <= this->m_windowEnd)
+                this->m_head[this->hash(position)] = position;
+        }
+
+        // Without flushing, keep enough input around that every match can reach its full length
+        void compress(bool flush) {
+            while (this->m_position < this->m_windowEnd && (flush || this->m_position + MaxMatch <= this->m_windowEnd)) {
+                const std::size_t available = std::min(MaxMatch, this->m_windowEnd - this->m_position);
+                std::size_t matchLength = 0, matchDistance = 0;
+
+                if (available >= MinMatch) {
+                    const auto key = this->hash(this->m_position);
+                    const auto candidate = this->m_head[key];
+                    this->m_head[key] = this->m_position;
+
+                    if (candidate >= 0 && this->m_position - candidate <= WindowSize) {
+                        const std::uint8_t *current = &this->m_window[this->m_position], *previous = &this->m_window[candidate];
+
+                        while (matchLength < available && current[matchLength] == previous[matchLength])
+                            matchLength++;
+
+                        matchDistance = this->m_position - candidate;
+                    }
+                }
+
+                if (matchLength >= MinMatch) {
+                    this->writeMatch(matchLength, matchDistance);
+
+                    for (std::size_t i = 1; i < matchLength; i++)
+                        this->insertHash(this->m_position + i);
+
+                    this->m_position += matchLength;
+                } else {
+                    this->writeLiteral(this->m_window[this->m_position]);
+                    this->m_position++;
+                }
+            }
+        }
+
+        // Huffman codes are stored starting with their most significant bit, everything else the other way around
+        void writeCode(std::uint32_t code, std::uint8_t length) {
+            std::uint32_t reversed = 0;
+            for (std::uint8_t bit = 0; bit < length; bit++)
+                reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+
+            this->writeBits(reversed, length);
+        }
+
+        void writeLiteral(std::uint16_t symbol) {
+            if (symbol < 144)
+                this->writeCode(0x30 + symbol, 8);
+            else if (symbol < 256)
+                this->writeCode(0x190 + (symbol - 144), 9);
+            else if (symbol < 280)
+                this->writeCode(symbol - 256, 7);
+            else
+                this->writeCode(0xC0 + (symbol - 280), 8);
+        }
+
+        void writeMatch(std::size_t length, std::size_t distance) {
+            const std::size_t lengthCode = std::upper_bound(std::begin(LengthBase), std::end(LengthBase), length) - std::begin(LengthBase) - 1;
+            this->writeLiteral(257 + lengthCode);
+            this->writeBits(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+            const std::size_t distanceCode = std::upper_bound(std::begin(DistanceBase), std::end(DistanceBase), distance) - std::begin(DistanceBase) - 1;
+            this->writeCode(distanceCode, 5);
+            this->writeBits(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+        }
+
+        void writeBits(std::uint32_t value, std::uint8_t count) {
+            this->m_bitBuffer |= value << this->m_bitCount;
+            this->m_bitCount += count;
+
+            while (this->m_bitCount >= 8) {
+                this->m_outputBuffer[this->m_outputSize++] = this->m_bitBuffer & 0xFF;
+                this->m_bitBuffer >>= 8;
+                this->m_bitCount -= 8;
+
+                if (this->m_outputSize == this->m_outputBuffer.size())
+                    this->flushOutput();
+            }
+        }
+
+        void flushOutput() {
+            if (this->m_outputSize > 0)
+                this->m_output(this->m_outputBuffer.data(), this->m_outputSize);
+
+            this->m_outputSize = 0;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pwswd::gfx {
+
+    /**
+     * 5x7 bitmap font covering space to 'Z'. Every glyph is stored as seven rows with the
+     * leftmost pixel in bit 4, lower case letters are drawn using their upper case glyph.
+     */
+    struct Font {
+        static constexpr char FirstCharacter = ' ';
+        static constexpr char LastCharacter = 'Z';
+        static constexpr std::uint8_t GlyphWidth = 5;
+        static constexpr std::uint8_t GlyphHeight = 7;
+        static constexpr std::uint8_t GlyphCount = LastCharacter - FirstCharacter + 1;
+
+        static constexpr std::uint8_t Glyphs[GlyphCount][GlyphHeight] = {
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // space
+            { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   // !
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // "
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // #
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // $
+            { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // %
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // &
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // (
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // )
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // *
+            { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   // +
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ,
+            { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   // -
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   // .
+            { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // /
+            { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // 0
+            { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 1
+            { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // 2
+            { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // 3
+            { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // 4
+            { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // 5
+            { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // 6
+            { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+            { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // 8
+            { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // 9
+            { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   // :
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ;
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // <
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // =
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // >
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ?
+            { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // @
+            { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // A
+            { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   // B
+            { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   // C
+            { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   // D
+            { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   // E
+            { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   // F
+            { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   // G
+            { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // H
+            { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // I
+            { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   // J
+            { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // K
+            { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   // L
+            { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   // M
+            { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // N
+            { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // O
+            { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   // P
+            { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   // Q
+            { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   // R
+            { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   // S
+            { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // T
+            { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // U
+            { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // V
+            { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   // W
+            { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   // X
+            { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 },   // Y
+            { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }    // Z
+        };
+
+        // Index into Glyphs, characters without a glyph map to space
+        [[nodiscard]] static constexpr std::uint8_t getGlyphIndex(char character) {
+            if (character >= 'a' && character <= 'z')
+                character -= 'a' - 'A';
+
+            if (character < FirstCharacter || character > LastCharacter)
+                return 0;
+
+            return character - FirstCharacter;
+        }
+
+        [[nodiscard]] static constexpr bool isPixelSet(std::uint8_t glyph, std::uint8_t x, std::uint8_t y) {
+            return Glyphs[glyph][y] & (1 << (GlyphWidth - 1 - x));
+        }
+    };
+
+    static_assert(Font::isPixelSet(Font::getGlyphIndex('T'), 0, 0) && !Font::isPixelSet(Font::getGlyphIndex('T'), 0, 1));
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "font.hpp"
+#include "surface.hpp"
+
+namespace pwswd::gfx {
+
+    /**
+     * The bitmap font expanded into the framebuffer's native pixel format, scaled and with a
+     * drop shadow. Built once whenever the pixel format changes so drawing text only copies
+     * runs of already encoded pixels.
+     */
+    class GlyphAtlas {
+    public:
+        template<typename Format>
+        void build(std::size_t formatId, std::uint8_t scale, std::uint32_t textColor, std::uint32_t shadowColor) {
+            constexpr auto bpp = Format::BytesPerPixel;
+
+            this->m_formatId = formatId;
+            this->m_scale = scale;
+            this->m_bytesPerPixel = bpp;
+            this->m_cellWidth = (Font::GlyphWidth + 1) * scale;
+            this->m_cellHeight = (Font::GlyphHeight + 1) * scale;
+
+            const std::size_t cellSize = this->m_cellWidth * this->m_cellHeight;
+            this->m_pixels.assign(Font::GlyphCount * cellSize * bpp, 0x00);
+            this->m_mask.assign(Font::GlyphCount * cellSize, false);
+
+            const std::uint32_t encodedText = Format::encode(textColor);
+            const std::uint32_t encodedShadow = Format::encode(shadowColor);
+
+            for (std::uint8_t glyph = 0; glyph < Font::GlyphCount; glyph++) {
+                for (std::uint32_t cellY = 0; cellY < this->m_cellHeight; cellY++) {
+                    for (std::uint32_t cellX = 0; cellX < this->m_cellWidth; cellX++) {
+                        const std::uint8_t fontX = cellX / scale, fontY = cellY / scale;
+                        const bool text = fontX < Font::GlyphWidth && fontY < Font::GlyphHeight && Font::isPixelSet(glyph, fontX, fontY);
+                        const bool shadow = fontX > 0 && fontY > 0 && Font::isPixelSet(glyph, fontX - 1, fontY - 1);
+
+                        if (!text && !shadow)
+                            continue;
+
+                        const std::size_t index = glyph * cellSize + cellY * this->m_cellWidth + cellX;
+                        std::memcpy(&this->m_pixels[index * bpp], text ? &encodedText : &encodedShadow, bpp);
+                        this->m_mask[index] = true;
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] bool isBuiltFor(std::size_t formatId, std::uint8_t scale) const {
+            return !this->m_pixels.empty() && this->m_formatId == formatId && this->m_scale == scale;
+        }
+
+        [[nodiscard]] std::uint32_t getTextWidth(const char *text) const {
+            return std::strlen(text) * this->m_cellWidth;
+        }
+
+        [[nodiscard]] std::uint32_t getTextHeight() const {
+            return this->m_cellHeight;
+        }
+
+        // Draws as many characters as fit into the surface, starting at x, y
+        void drawText(const Surface &surface, std::uint32_t x, std::uint32_t y, const char *text) const {
+            if (surface.bytesPerPixel != this->m_bytesPerPixel || y + this->m_cellHeight > surface.height)
+                return;
+
+            for (; *text != '\0' && x + this->m_cellWidth <= surface.width; text++, x += this->m_cellWidth)
+                this->drawGlyph(surface, x, y, Font::getGlyphIndex(*text));
+        }
+
+    private:
+        std::size_t m_formatId = 0;
+        std::uint8_t m_scale = 0;
+        std::uint8_t m_bytesPerPixel = 0;
+        std::uint32_t m_cellWidth = 0, m_cellHeight = 0;
+
+        std::vector<std::uint8_t> m_pixels;
+        std::vector<bool> m_mask;
+
+        void drawGlyph(const Surface &surface, std::uint32_t x, std::uint32_t y, std::uint8_t glyph) const {
+            const std::size_t cellSize = this->m_cellWidth * this->m_cellHeight;
+            const auto bpp = this->m_bytesPerPixel;
+
+            for (std::uint32_t row = 0; row < this->m_cellHeight; row++) {
+                const std::size_t rowStart = glyph * cellSize + row * this->m_cellWidth;
+                std::uint8_t *dst = surface.getPixelAddress(x, y + row);
+
+                // Copy every run of covered pixels in one go
+                for (std::uint32_t column = 0; column < this->m_cellWidth;) {
+                    if (!this->m_mask[rowStart + column]) {
+                        column++;
+                        continue;
+                    }
+
+                    std::uint32_t runEnd = column;
+                    while (runEnd < this->m_cellWidth && this->m_mask[rowStart + runEnd])
+                        runEnd++;
+
+                    std::memcpy(dst + column * bpp, &this->m_pixels[(rowStart + column) * bpp], (runEnd - column) * bpp);
+                    column = runEnd;
+                }
+            }
+        }
+    };
+
+}
\ No newline at end of file
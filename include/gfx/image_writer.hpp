@@ -0,0 +1,275 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "deflate.hpp"
+
+namespace pwswd::gfx {
+
+    /**
+     * Writes an image to a file one row at a time, so only a single row has to be converted
+     * and kept in memory at once. Rows are given as packed 8 bit RGB, top to bottom.
+     * Write errors can be checked with std::ferror on the file afterwards.
+     */
+    class ImageWriter {
+    public:
+        explicit ImageWriter(std::FILE *file) : m_file(file) { }
+        virtual ~ImageWriter() = default;
+
+        virtual void begin(std::uint32_t width, std::uint32_t height) = 0;
+        virtual void writeRow(const std::uint8_t *pixels) = 0;
+        virtual void end() = 0;
+
+    protected:
+        std::FILE *m_file;
+        std::uint32_t m_width = 0, m_height = 0;
+
+        void write(const void *data, std::size_t size) {
+            std::fwrite(data, 1, size, this->m_file);
+        }
+
+        void writeBigEndian(std::uint32_t value) {
+            const std::uint8_t bytes[] = { std::uint8_t(value >> 24), std::uint8_t(value >> 16), std::uint8_t(value >> 8), std::uint8_t(value) };
+            this->write(bytes, sizeof(bytes));
+        }
+
+        void writeLittleEndian(std::uint32_t value, std::uint8_t size) {
+            const std::uint8_t bytes[] = { std::uint8_t(value), std::uint8_t(value >> 8), std::uint8_t(value >> 16), std::uint8_t(value >> 24) };
+            this->write(bytes, size);
+        }
+    };
+
+    // Uncompressed 24 bit BMP, stored top down. Fastest to write but biggest on the SD card
+    class BmpWriter : public ImageWriter {
+    public:
+        using ImageWriter::ImageWriter;
+
+        void begin(std::uint32_t width, std::uint32_t height) override {
+            this->m_width = width;
+            this->m_height = height;
+            this->m_row.resize((width * 3 + 3) & ~3U, 0x00);
+
+            const std::uint32_t headerSize = 14 + 40;
+            const std::uint32_t imageSize = this->m_row.size() * height;
+
+            // File header
+            this->write("BM", 2);
+            this->writeLittleEndian(headerSize + imageSize, 4);
+            this->writeLittleEndian(0, 4);
+            this->writeLittleEndian(headerSize, 4);
+
+            // Info header, a negative height means the rows are stored top down
+            this->writeLittleEndian(40, 4);
+            this->writeLittleEndian(width, 4);
+            this->writeLittleEndian(-std::int32_t(height), 4);
+            this->writeLittleEndian(1, 2);
+            this->writeLittleEndian(24, 2);
+            this->writeLittleEndian(0, 4);
+            this->writeLittleEndian(imageSize, 4);
+            this->writeLittleEndian(2835, 4);
+            this->writeLittleEndian(2835, 4);
+            this->writeLittleEndian(0, 4);
+            this->writeLittleEndian(0, 4);
+        }
+
+        void writeRow(const std::uint8_t *pixels) override {
+            for (std::uint32_t x = 0; x < this->m_width; x++) {
+                this->m_row[x * 3 + 0] = pixels[x * 3 + 2];
+                this->m_row[x * 3 + 1] = pixels[x * 3 + 1];
+                this->m_row[x * 3 + 2] = pixels[x * 3 + 0];
+            }
+
+            this->write(this->m_row.data(), this->m_row.size());
+        }
+
+        void end() override { }
+
+    private:
+        std::vector<std::uint8_t> m_row;
+    };
+
+    // Quite OK Image format, compresses about as well as PNG at a fraction of the CPU time
+    class QoiWriter : public ImageWriter {
+    public:
+        using ImageWriter::ImageWriter;
+
+        void begin(std::uint32_t width, std::uint32_t height) override {
+            this->m_width = width;
+            this->m_height = height;
+            this->m_index.fill(0);
+            this->m_previous = 0x000000FF;
+            this->m_run = 0;
+
+            this->write("qoif", 4);
+            this->writeBigEndian(width);
+            this->writeBigEndian(height);
+
+            // 3 channels, sRGB
+            const std::uint8_t format[] = { 3, 0 };
+            this->write(format, sizeof(format));
+        }
+
+        void writeRow(const std::uint8_t *pixels) override {
+            this->m_chunks.clear();
+
+            for (std::uint32_t x = 0; x < this->m_width; x++) {
+                const std::uint8_t r = pixels[x * 3 + 0], g = pixels[x * 3 + 1], b = pixels[x * 3 + 2];
+                const std::uint32_t pixel = std::uint32_t(r) << 24 | std::uint32_t(g) << 16 | std::uint32_t(b) << 8 | 0xFF;
+
+                if (pixel == this->m_previous) {
+                    this->m_run++;
+                    if (this->m_run == 62)
+                        this->flushRun();
+
+                    continue;
+                }
+
+                this->flushRun();
+
+                const std::uint8_t hash = (r * 3 + g * 5 + b * 7 + 0xFF * 11) % 64;
+                if (this->m_index[hash] == pixel) {
+                    this->m_chunks.push_back(OpIndex | hash);
+                } else {
+                    this->m_index[hash] = pixel;
+
+                    const std::int8_t dr = r - std::uint8_t(this->m_previous >> 24);
+                    const std::int8_t dg = g - std::uint8_t(this->m_previous >> 16);
+                    const std::int8_t db = b - std::uint8_t(this->m_previous >> 8);
+                    const std::int8_t drg = dr - dg, dbg = db - dg;
+
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        this->m_chunks.push_back(OpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                        this->m_chunks.push_back(OpLuma | (dg + 32));
+                        this->m_chunks.push_back((drg + 8) << 4 | (dbg + 8));
+                    } else {
+                        this->m_chunks.insert(this->m_chunks.end(), { OpRGB, r, g, b });
+                    }
+                }
+
+                this->m_previous = pixel;
+            }
+
+            this->write(this->m_chunks.data(), this->m_chunks.size());
+        }
+
+        void end() override {
+            this->m_chunks.clear();
+            this->flushRun();
+
+            const std::uint8_t padding[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+            this->m_chunks.insert(this->m_chunks.end(), std::begin(padding), std::end(padding));
+
+            this->write(this->m_chunks.data(), this->m_chunks.size());
+        }
+
+    private:
+        static constexpr std::uint8_t OpIndex = 0x00;
+        static constexpr std::uint8_t OpDiff  = 0x40;
+        static constexpr std::uint8_t OpLuma  = 0x80;
+        static constexpr std::uint8_t OpRun   = 0xC0;
+        static constexpr std::uint8_t OpRGB   = 0xFE;
+
+        std::array<std::uint32_t, 64> m_index;
+        std::uint32_t m_previous;
+        std::uint8_t m_run;
+
+        std::vector<std::uint8_t> m_chunks;
+
+        void flushRun() {
+            if (this->m_run == 0)
+                return;
+
+            this->m_chunks.push_back(OpRun | (this->m_run - 1));
+            this->m_run = 0;
+        }
+    };
+
+    // 8 bit RGB PNG. Rows use the sub filter and get compressed as they come in
+    class PngWriter : public ImageWriter {
+    public:
+        explicit PngWriter(std::FILE *file) : ImageWriter(file), m_deflate([this](const std::uint8_t *data, std::size_t size) { this->writeImageData(data, size); }) { }
+
+        void begin(std::uint32_t width, std::uint32_t height) override {
+            this->m_width = width;
+            this->m_height = height;
+            this->m_row.resize(width * 3 + 1);
+            this->m_chunkSize = 0;
+            this->m_deflate.reset();
+
+            const std::uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            this->write(signature, sizeof(signature));
+
+            // Bit depth 8, RGB, deflate, adaptive filtering, no interlacing
+            std::uint8_t header[13] = { 0 };
+            for (std::uint8_t i = 0; i < 4; i++) {
+                header[i]     = width >> (24 - i * 8);
+                header[4 + i] = height >> (24 - i * 8);
+            }
+            header[8] = 8;
+            header[9] = 2;
+
+            this->writeChunk("IHDR", header, sizeof(header));
+        }
+
+        void writeRow(const std::uint8_t *pixels) override {
+            // Sub filter, every byte is stored as the difference to the same channel of the pixel on its left
+            this->m_row[0] = 1;
+            for (std::uint32_t i = 0; i < this->m_width * 3; i++)
+                this->m_row[i + 1] = pixels[i] - (i >= 3 ? pixels[i - 3] : 0);
+
+            this->m_deflate.write(this->m_row.data(), this->m_row.size());
+        }
+
+        void end() override {
+            this->m_deflate.finish();
+            this->flushImageData();
+
+            this->writeChunk("IEND", nullptr, 0);
+        }
+
+    private:
+        static constexpr std::size_t MaxChunkSize = 32 * 1024;
+
+        DeflateStream m_deflate;
+        std::vector<std::uint8_t> m_row;
+
+        std::array<std::uint8_t, MaxChunkSize> m_chunk;
+        std::size_t m_chunkSize = 0;
+
+        void writeChunk(const char *type, const std::uint8_t *data, std::size_t size) {
+            this->writeBigEndian(size);
+            this->write(type, 4);
+            if (size > 0)
+                this->write(data, size);
+
+            std::uint32_t crc = crc32(0, reinterpret_cast<const std::uint8_t*>(type), 4);
+            this->writeBigEndian(crc32(crc, data, size));
+        }
+
+        // Compressed data is split up into IDAT chunks of fixed size
+        void writeImageData(const std::uint8_t *data, std::size_t size) {
+            while (size > 0) {
+                std::size_t copySize = std::min(size, MaxChunkSize - this->m_chunkSize);
+                std::memcpy(&this->m_chunk[this->m_chunkSize], data, copySize);
+                this->m_chunkSize += copySize;
+                data += copySize;
+                size -= copySize;
+
+                if (this->m_chunkSize == MaxChunkSize)
+                    this->flushImageData();
+            }
+        }
+
+        void flushImageData() {
+            if (this->m_chunkSize > 0)
+                this->writeChunk("IDAT", this->m_chunk.data(), this->m_chunkSize);
+
+            this->m_chunkSize = 0;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <variant>
+
+namespace pwswd::gfx {
+
+    /**
+     * Compile time description of a packed pixel layout. Colors are given as 0xRRGGBBAA
+     * and get truncated to the channel sizes of the format.
+     */
+    template<std::uint8_t BytesPerPixelValue,
+             std::uint8_t RedOffset, std::uint8_t RedLength,
+             std::uint8_t GreenOffset, std::uint8_t GreenLength,
+             std::uint8_t BlueOffset, std::uint8_t BlueLength,
+             std::uint8_t AlphaOffset = 0, std::uint8_t AlphaLength = 0>
+    struct PixelFormat {
+        static constexpr std::uint8_t BytesPerPixel = BytesPerPixelValue;
+
+        [[nodiscard]] static constexpr std::uint32_t encode(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
+            return pack<RedOffset, RedLength>(r) | pack<GreenOffset, GreenLength>(g) | pack<BlueOffset, BlueLength>(b) | pack<AlphaOffset, AlphaLength>(a);
+        }
+
+        [[nodiscard]] static constexpr std::uint32_t encode(std::uint32_t color) {
+            return encode(color >> 24, color >> 16, color >> 8, color);
+        }
+
+        // Expands a pixel back to 0xRRGGBBAA, replicating the top bits into the ones the format doesn't store
+        [[nodiscard]] static constexpr std::uint32_t decode(std::uint32_t pixel) {
+            std::uint32_t alpha = AlphaLength == 0 ? 0xFF : unpack<AlphaOffset, AlphaLength>(pixel);
+
+            return unpack<RedOffset, RedLength>(pixel) << 24 | unpack<GreenOffset, GreenLength>(pixel) << 16 | unpack<BlueOffset, BlueLength>(pixel) << 8 | alpha;
+        }
+
+        // Linearly interpolates every channel between dst and src, alpha 255 yields src
+        [[nodiscard]] static constexpr std::uint32_t blend(std::uint32_t dst, std::uint32_t src, std::uint8_t alpha) {
+            return blendChannel<RedOffset, RedLength>(dst, src, alpha) |
+                   blendChannel<GreenOffset, GreenLength>(dst, src, alpha) |
+                   blendChannel<BlueOffset, BlueLength>(dst, src, alpha) |
+                   (dst & mask<AlphaOffset, AlphaLength>());
+        }
+
+        [[nodiscard]] static constexpr bool matches(std::uint32_t bitsPerPixel,
+                                                    std::uint32_t redOffset, std::uint32_t redLength,
+                                                    std::uint32_t greenOffset, std::uint32_t greenLength,
+                                                    std::uint32_t blueOffset, std::uint32_t blueLength) {
+            return (bitsPerPixel + 7) / 8 == BytesPerPixel &&
+                   redOffset == RedOffset && redLength == RedLength &&
+                   greenOffset == GreenOffset && greenLength == GreenLength &&
+                   blueOffset == BlueOffset && blueLength == BlueLength;
+        }
+
+    private:
+        template<std::uint8_t Offset, std::uint8_t Length>
+        [[nodiscard]] static constexpr std::uint32_t mask() {
+            if constexpr (Length == 0)
+                return 0;
+            else
+                return ((1U << Length) - 1) << Offset;
+        }
+
+        template<std::uint8_t Offset, std::uint8_t Length>
+        [[nodiscard]] static constexpr std::uint32_t pack(std::uint8_t value) {
+            if constexpr (Length == 0)
+                return 0;
+            else
+                return std::uint32_t(value >> (8 - Length)) << Offset;
+        }
+
+        template<std::uint8_t Offset, std::uint8_t Length>
+        [[nodiscard]] static constexpr std::uint32_t unpack(std::uint32_t pixel) {
+            if constexpr (Length == 0)
+                return 0;
+            else if constexpr (Length >= 8)
+                return (pixel >> Offset) & 0xFF;
+            else {
+                std::uint32_t value = (pixel >> Offset) & ((1U << Length) - 1);
+                return (value << (8 - Length)) | (value >> (2 * Length - 8));
+            }
+        }
+
+        template<std::uint8_t Offset, std::uint8_t Length>
+        [[nodiscard]] static constexpr std::uint32_t blendChannel(std::uint32_t dst, std::uint32_t src, std::uint8_t alpha) {
+            if constexpr (Length == 0)
+                return 0;
+            else {
+                std::uint32_t dstValue = (dst >> Offset) & ((1U << Length) - 1);
+                std::uint32_t srcValue = (src >> Offset) & ((1U << Length) - 1);
+
+                return ((dstValue * (255 - alpha) + srcValue * alpha + 127) / 255) << Offset;
+            }
+        }
+    };
+
+    using RGB555    = PixelFormat<2, 10, 5,  5, 5,  0, 5>;
+    using BGR555    = PixelFormat<2,  0, 5,  5, 5, 10, 5>;
+    using RGB565    = PixelFormat<2, 11, 5,  5, 6,  0, 5>;
+    using BGR565    = PixelFormat<2,  0, 5,  5, 6, 11, 5>;
+    using RGB888    = PixelFormat<3, 16, 8,  8, 8,  0, 8>;
+    using BGR888    = PixelFormat<3,  0, 8,  8, 8, 16, 8>;
+    using XRGB8888  = PixelFormat<4, 16, 8,  8, 8,  0, 8, 24, 8>;
+    using XBGR8888  = PixelFormat<4,  0, 8,  8, 8, 16, 8, 24, 8>;
+
+    // Only the alpha channel, used for the coverage planes that go along with off-screen surfaces
+    using Alpha8    = PixelFormat<1,  0, 0,  0, 0,  0, 0,  0, 8>;
+
+    // std::monostate stands for layouts no specialisation exists for, nothing gets drawn then
+    using AnyPixelFormat = std::variant<std::monostate, RGB555, BGR555, RGB565, BGR565, RGB888, BGR888, XRGB8888, XBGR8888>;
+
+    template<std::size_t Index = 1>
+    [[nodiscard]] constexpr AnyPixelFormat findPixelFormat(std::uint32_t bitsPerPixel,
+                                                           std::uint32_t redOffset, std::uint32_t redLength,
+                                                           std::uint32_t greenOffset, std::uint32_t greenLength,
+                                                           std::uint32_t blueOffset, std::uint32_t blueLength) {
+        if constexpr (Index == std::variant_size_v<AnyPixelFormat>)
+            return std::monostate();
+        else {
+            using Format = std::variant_alternative_t<Index, AnyPixelFormat>;
+
+            if (Format::matches(bitsPerPixel, redOffset, redLength, greenOffset, greenLength, blueOffset, blueLength))
+                return Format();
+            else
+                return findPixelFormat<Index + 1>(bitsPerPixel, redOffset, redLength, greenOffset, greenLength, blueOffset, blueLength);
+        }
+    }
+
+    static_assert(RGB565::encode(0xFF0000FF) == 0xF800);
+    static_assert(BGR565::encode(0xFF0000FF) == 0x001F);
+    static_assert(XRGB8888::encode(0x00FF00FF) == 0xFF00FF00);
+    static_assert(RGB565::blend(0x0000, 0xFFFF, 255) == 0xFFFF);
+    static_assert(Alpha8::encode(0x123456C0) == 0xC0);
+    static_assert(RGB565::decode(0xF81F) == 0xFF00FFFF);
+    static_assert(XRGB8888::decode(XRGB8888::encode(0x12345678)) == 0x12345678);
+
+}
\ No newline at end of file
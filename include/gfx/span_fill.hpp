@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace pwswd::gfx {
+
+    // Word type that may alias the byte buffers it's used on
+    using Word = std::uint32_t __attribute__((__may_alias__));
+    using HalfWord = std::uint16_t __attribute__((__may_alias__));
+
+    /**
+     * Fills count pixels starting at dst with an already encoded color. Unaligned pixels at
+     * the start and end of the span are written one by one, everything in between with
+     * aligned word sized stores. Pixels are expected to be aligned to their own size.
+     */
+    template<std::uint8_t BytesPerPixel>
+    inline void fillSpan(std::uint8_t *dst, std::uint32_t count, std::uint32_t color);
+
+    template<>
+    inline void fillSpan<1>(std::uint8_t *dst, std::uint32_t count, std::uint32_t color) {
+        std::memset(dst, color, count);
+    }
+
+    template<>
+    inline void fillSpan<2>(std::uint8_t *dst, std::uint32_t count, std::uint32_t color) {
+        if (count == 0)
+            return;
+
+        // Head, single pixel until the destination is word aligned
+        if (reinterpret_cast<std::uintptr_t>(dst) & 0b10) {
+            *reinterpret_cast<HalfWord*>(dst) = color;
+            dst += 2;
+            count--;
+        }
+
+        // Body, two pixels per store
+        const Word pattern = (color & 0xFFFF) * 0x0001'0001;
+        auto words = reinterpret_cast<Word*>(dst);
+
+        for (; count >= 8; count -= 8, words += 4) {
+            words[0] = pattern;
+            words[1] = pattern;
+            words[2] = pattern;
+            words[3] = pattern;
+        }
+
+        for (; count >= 2; count -= 2)
+            *words++ = pattern;
+
+        // Tail, remaining odd pixel
+        if (count)
+            *reinterpret_cast<HalfWord*>(words) = color;
+    }
+
+    template<>
+    inline void fillSpan<3>(std::uint8_t *dst, std::uint32_t count, std::uint32_t color) {
+        const std::uint8_t b0 = color, b1 = color >> 8, b2 = color >> 16;
+
+        auto writePixel = [&](std::uint8_t *pixel) {
+            pixel[0] = b0;
+            pixel[1] = b1;
+            pixel[2] = b2;
+        };
+
+        // Head, at most three pixels until the destination is word aligned
+        while (count > 0 && (reinterpret_cast<std::uintptr_t>(dst) & 0b11)) {
+            writePixel(dst);
+            dst += 3;
+            count--;
+        }
+
+        // Body, four pixels are exactly three words
+        const Word pattern[3] = {
+            Word(b0) | Word(b1) << 8 | Word(b2) << 16 | Word(b0) << 24,
+            Word(b1) | Word(b2) << 8 | Word(b0) << 16 | Word(b1) << 24,
+            Word(b2) | Word(b0) << 8 | Word(b1) << 16 | Word(b2) << 24
+        };
+
+        auto words = reinterpret_cast<Word*>(dst);
+        for (; count >= 4; count -= 4, words += 3) {
+            words[0] = pattern[0];
+            words[1] = pattern[1];
+            words[2] = pattern[2];
+        }
+
+        // Tail, remaining pixels
+        dst = reinterpret_cast<std::uint8_t*>(words);
+        for (; count > 0; count--, dst += 3)
+            writePixel(dst);
+    }
+
+    template<>
+    inline void fillSpan<4>(std::uint8_t *dst, std::uint32_t count, std::uint32_t color) {
+        auto words = reinterpret_cast<Word*>(dst);
+
+        for (; count >= 4; count -= 4, words += 4) {
+            words[0] = color;
+            words[1] = color;
+            words[2] = color;
+            words[3] = color;
+        }
+
+        for (; count > 0; count--)
+            *words++ = color;
+    }
+
+    // Fills a rect row by row, pitch is the distance between two rows in bytes
+    template<std::uint8_t BytesPerPixel>
+    inline void fillRect(std::uint8_t *dst, std::size_t pitch, std::uint32_t width, std::uint32_t height, std::uint32_t color) {
+        for (std::uint32_t row = 0; row < height; row++, dst += pitch)
+            fillSpan<BytesPerPixel>(dst, width, color);
+    }
+
+}
\ No newline at end of file
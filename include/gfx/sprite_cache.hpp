@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "surface.hpp"
+
+namespace pwswd::gfx {
+
+    // Pixels in the framebuffer's native format with one alpha byte per pixel next to them
+    struct Sprite {
+        Surface pixels;
+        Surface alpha;
+
+        // Set once every alpha value is 0xFF, the sprite can be copied instead of blended then
+        bool opaque;
+    };
+
+    /**
+     * Off-screen sprites looked up by a caller chosen key. Once the total size exceeds the
+     * budget, the least recently used sprites get dropped.
+     */
+    class SpriteCache {
+    public:
+        explicit SpriteCache(std::size_t maxBytes) : m_maxBytes(maxBytes) { }
+
+        // Returns the cached sprite and marks it as recently used, nullptr if there's none for this key
+        [[nodiscard]] Sprite* find(std::uint64_t key) {
+            auto entry = this->m_entries.find(key);
+            if (entry == this->m_entries.end())
+                return nullptr;
+
+            this->m_sprites.splice(this->m_sprites.begin(), this->m_sprites, entry->second);
+
+            return &entry->second->sprite;
+        }
+
+        // Allocates a new sprite for the key, the caller has to draw into every pixel and alpha value of it
+        [[nodiscard]] Sprite& insert(std::uint64_t key, std::uint32_t width, std::uint32_t height, std::uint8_t bytesPerPixel) {
+            this->erase(key);
+
+            const std::size_t pixelCount = std::size_t(width) * height;
+            const std::size_t size = pixelCount * (bytesPerPixel + 1);
+            while (!this->m_sprites.empty() && this->m_usedBytes + size > this->m_maxBytes)
+                this->erase(this->m_sprites.back().key);
+
+            // Pixels and alpha values share one allocation
+            auto &entry = this->m_sprites.emplace_front();
+            entry.key = key;
+            entry.storage.resize(size);
+            entry.sprite.pixels = { entry.storage.data(), std::size_t(width) * bytesPerPixel, width, height, bytesPerPixel };
+            entry.sprite.alpha = { entry.storage.data() + pixelCount * bytesPerPixel, width, width, height, 1 };
+            entry.sprite.opaque = false;
+
+            this->m_entries[key] = this->m_sprites.begin();
+            this->m_usedBytes += size;
+
+            return entry.sprite;
+        }
+
+        void clear() {
+            this->m_entries.clear();
+            this->m_sprites.clear();
+            this->m_usedBytes = 0;
+        }
+
+        [[nodiscard]] std::size_t getUsedBytes() const {
+            return this->m_usedBytes;
+        }
+
+        [[nodiscard]] std::size_t getCount() const {
+            return this->m_sprites.size();
+        }
+
+    private:
+        struct Entry {
+            std::uint64_t key;
+            std::vector<std::uint8_t> storage;
+            Sprite sprite;
+        };
+
+        std::size_t m_maxBytes;
+        std::size_t m_usedBytes = 0;
+
+        // Most recently used sprite first
+        std::list<Entry> m_sprites;
+        std::map<std::uint64_t, std::list<Entry>::iterator> m_entries;
+
+        void erase(std::uint64_t key) {
+            auto entry = this->m_entries.find(key);
+            if (entry == this->m_entries.end())
+                return;
+
+            this->m_usedBytes -= entry->second->storage.size();
+            this->m_sprites.erase(entry->second);
+            this->m_entries.erase(entry);
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "span_fill.hpp"
+
+namespace pwswd::gfx {
+
+    // View of a block of pixels in some native format, either part of the framebuffer or an off-screen buffer
+    struct Surface {
+        std::uint8_t *data;
+        std::size_t pitch;
+        std::uint32_t width, height;
+        std::uint8_t bytesPerPixel;
+
+        [[nodiscard]] std::uint8_t* getPixelAddress(std::uint32_t x, std::uint32_t y) const {
+            return this->data + y * this->pitch + x * this->bytesPerPixel;
+        }
+
+        // Part of this surface, clipped to its bounds
+        [[nodiscard]] Surface getSubSurface(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h) const {
+            if (x >= this->width || y >= this->height)
+                return { this->data, this->pitch, 0, 0, this->bytesPerPixel };
+
+            return { this->getPixelAddress(x, y), this->pitch, std::min(w, this->width - x), std::min(h, this->height - y), this->bytesPerPixel };
+        }
+    };
+
+    template<typename Format>
+    inline void fillRect(const Surface &surface, std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t color) {
+        auto area = surface.getSubSurface(x, y, w, h);
+
+        fillRect<Format::BytesPerPixel>(area.data, area.pitch, area.width, area.height, Format::encode(color));
+    }
+
+    // Copies src into the top left corner of dst, both have to be in the same format
+    inline void blit(const Surface &dst, const Surface &src) {
+        if (dst.bytesPerPixel != src.bytesPerPixel)
+            return;
+
+        const std::size_t rowSize = std::size_t(std::min(dst.width, src.width)) * src.bytesPerPixel;
+        const std::uint32_t rows = std::min(dst.height, src.height);
+
+        for (std::uint32_t y = 0; y < rows; y++)
+            std::memcpy(dst.data + y * dst.pitch, src.data + y * src.pitch, rowSize);
+    }
+
+}
\ No newline at end of file
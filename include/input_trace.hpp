@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "events.hpp"
+
+namespace pwswd {
+
+    enum class TraceSource : std::uint8_t {
+        Buttons  = 0,
+        Joystick = 1
+    };
+
+    struct TraceFrame {
+        TraceSource source;
+        std::uint64_t time;
+        std::vector<InputEvent> events;
+    };
+
+    /**
+     * Trace files start with a magic and a version, followed by one 13 byte record per event:
+     * microseconds since the previous record, source, type, code and value in the native byte order.
+     * Every frame ends with a SYN_REPORT record of its source, like on the device.
+     */
+    class TraceWriter {
+    public:
+        explicit TraceWriter(const std::string &path) {
+            this->m_file = std::fopen(path.c_str(), "wb");
+
+            if (this->m_file == nullptr)
+                throw std::runtime_error("Failed to open trace " + path);
+
+            std::fwrite(Magic, 1, sizeof(Magic), this->m_file);
+            const std::uint8_t version = Version;
+            std::fwrite(&version, 1, 1, this->m_file);
+        }
+
+        ~TraceWriter() {
+            std::fclose(this->m_file);
+        }
+
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        void writeFrame(TraceSource source, const InputFrame &frame) {
+            if (frame.empty())
+                return;
+
+            for (const auto &event : frame)
+                this->writeRecord(source, event);
+
+            auto syncEvent = createSyncEvent();
+            syncEvent.time = (frame.end() - 1)->time;
+            this->writeRecord(source, syncEvent);
+        }
+
+        // Records are buffered, call once per wakeup so a killed daemon doesn't lose much of the trace
+        void flush() {
+            std::fflush(this->m_file);
+        }
+
+    private:
+        static constexpr char Magic[4] = { 'P', 'W', 'T', 'R' };
+        static constexpr std::uint8_t Version = 1;
+        static constexpr std::size_t RecordSize = 13;
+
+        friend class TraceReader;
+
+        std::FILE *m_file;
+        std::uint64_t m_lastTime = 0;
+
+        void writeRecord(TraceSource source, const InputEvent &event) {
+            const std::uint64_t time = toMicroSeconds(event.time);
+
+            // Frames of both devices are written in the order they were read, not by their timestamps. A record older
+            // than the one before it gets the same time, the reference never moves backwards so later records keep
+            // their timing. Deltas of more than an hour get clamped instead of wrapping
+            std::uint32_t delta = 0;
+            if (this->m_lastTime != 0 && time > this->m_lastTime)
+                delta = std::min<std::uint64_t>(time - this->m_lastTime, UINT32_MAX);
+            this->m_lastTime = std::max(this->m_lastTime, time);
+
+            std::uint8_t record[RecordSize];
+            std::memcpy(&record[0], &delta, 4);
+            record[4] = static_cast<std::uint8_t>(source);
+            std::memcpy(&record[5], &event.type, 2);
+            std::memcpy(&record[7], &event.code, 2);
+            std::memcpy(&record[9], &event.value, 4);
+
+            std::fwrite(record, 1, sizeof(record), this->m_file);
+        }
+    };
+
+    // Reads back the frames of a trace one at a time, with their time relative to the start of the trace
+    class TraceReader {
+    public:
+        explicit TraceReader(const std::string &path) {
+            this->m_file = std::fopen(path.c_str(), "rb");
+
+            if (this->m_file == nullptr)
+                throw std::runtime_error("Failed to open trace " + path);
+
+            char magic[sizeof(TraceWriter::Magic)];
+            std::uint8_t version = 0;
+            if (std::fread(magic, 1, sizeof(magic), this->m_file) != sizeof(magic) || std::memcmp(magic, TraceWriter::Magic, sizeof(magic)) != 0 ||
+                std::fread(&version, 1, 1, this->m_file) != 1 || version != TraceWriter::Version) {
+                std::fclose(this->m_file);
+                throw std::runtime_error("Invalid trace " + path);
+            }
+        }
+
+        ~TraceReader() {
+            std::fclose(this->m_file);
+        }
+
+        TraceReader(const TraceReader&) = delete;
+        TraceReader& operator=(const TraceReader&) = delete;
+
+        // Frames of both sources are returned in the order they were recorded, nothing once the trace ended
+        [[nodiscard]] std::optional<TraceFrame> readFrame() {
+            std::uint8_t record[TraceWriter::RecordSize];
+
+            while (std::fread(record, 1, sizeof(record), this->m_file) == sizeof(record)) {
+                std::uint32_t delta;
+                InputEvent event = { };
+                std::memcpy(&delta, &record[0], 4);
+                std::memcpy(&event.type, &record[5], 2);
+                std::memcpy(&event.code, &record[7], 2);
+                std::memcpy(&event.value, &record[9], 4);
+
+                const auto source = static_cast<TraceSource>(record[4]);
+                if (source != TraceSource::Buttons && source != TraceSource::Joystick)
+                    continue;
+
+                this->m_time += delta;
+                event.time = { time_t(this->m_time / 1'000'000), suseconds_t(this->m_time % 1'000'000) };
+
+                auto &pending = this->m_pending[static_cast<std::uint8_t>(source)];
+                if (event.type == static_cast<std::uint16_t>(EventType::Synchronization) && event.code == static_cast<std::uint16_t>(SynchronizationEvent::Report)) {
+                    TraceFrame frame = { source, this->m_time, std::move(pending) };
+                    pending.clear();
+
+                    if (!frame.events.empty())
+                        return frame;
+                } else {
+                    pending.push_back(event);
+                }
+            }
+
+            return std::nullopt;
+        }
+
+    private:
+        std::FILE *m_file;
+        std::uint64_t m_time = 0;
+
+        // Frames of the two sources can interleave
+        std::vector<InputEvent> m_pending[2];
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace pwswd {
+
+    /**
+     * Histogram of latencies in microseconds with a fixed set of logarithmic buckets. Every power
+     * of two is split up into a few buckets, so percentiles are accurate to about 25% from a
+     * microsecond up to over a minute while recording stays a handful of instructions.
+     */
+    class LatencyHistogram {
+    public:
+        void record(std::uint64_t latency) {
+            this->m_buckets[getBucket(latency)]++;
+            this->m_count++;
+            this->m_total += latency;
+            this->m_max = std::max(this->m_max, latency);
+        }
+
+        // Upper bound of the bucket the given percentile falls into, never more than the largest latency recorded
+        [[nodiscard]] std::uint64_t getPercentile(std::uint32_t percentile) const {
+            if (this->m_count == 0)
+                return 0;
+
+            const std::uint64_t target = std::max<std::uint64_t>((this->m_count * std::min<std::uint32_t>(percentile, 100) + 99) / 100, 1);
+
+            std::uint64_t count = 0;
+            for (std::size_t bucket = 0; bucket < BucketCount; bucket++) {
+                count += this->m_buckets[bucket];
+
+                // The last bucket also collects everything too large for the others
+                if (count >= target)
+                    return bucket == BucketCount - 1 ? this->m_max : std::min(getUpperBound(bucket), this->m_max);
+            }
+
+            return this->m_max;
+        }
+
+        [[nodiscard]] std::uint64_t getCount() const {
+            return this->m_count;
+        }
+
+        [[nodiscard]] std::uint64_t getMean() const {
+            return this->m_count > 0 ? this->m_total / this->m_count : 0;
+        }
+
+        [[nodiscard]] std::uint64_t getMax() const {
+            return this->m_max;
+        }
+
+    private:
+        static constexpr std::uint8_t SubBucketBits = 2;
+        static constexpr std::uint8_t MaxExponent = 26;
+        static constexpr std::size_t BucketCount = MaxExponent << SubBucketBits;
+
+        std::array<std::uint32_t, BucketCount> m_buckets = { 0 };
+        std::uint64_t m_count = 0, m_total = 0, m_max = 0;
+
+        // Values below 1 << SubBucketBits get a bucket each, everything above is bucketed by its top bits
+        [[nodiscard]] static std::size_t getBucket(std::uint64_t value) {
+            if (value < (1U << SubBucketBits))
+                return value;
+
+            const std::uint8_t exponent = 63 - __builtin_clzll(value);
+            if (exponent > MaxExponent)
+                return BucketCount - 1;
+
+            const std::size_t mantissa = (value >> (exponent - SubBucketBits)) & ((1U << SubBucketBits) - 1);
+            return ((exponent - SubBucketBits + 1) << SubBucketBits) + mantissa;
+        }
+
+        [[nodiscard]] static std::uint64_t getUpperBound(std::size_t bucket) {
+            if (bucket < (1U << SubBucketBits))
+                return bucket;
+
+            const std::uint8_t exponent = (bucket >> SubBucketBits) + SubBucketBits - 1;
+            const std::uint64_t mantissa = bucket & ((1U << SubBucketBits) - 1);
+            const std::uint64_t width = 1ULL << (exponent - SubBucketBits);
+
+            return (((1ULL << SubBucketBits) + mantissa) << (exponent - SubBucketBits)) + width - 1;
+        }
+    };
+
+}
\ No newline at end of file
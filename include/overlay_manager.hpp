@@ -1,12 +1,22 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
-#include <queue>
+#include <cstdio>
+#include <array>
+#include <atomic>
+#include <variant>
+#include <vector>
 
 #include <sys/time.h>
 
 #include "devices/framebuffer.hpp"
+#include "bounded_queue.hpp"
+#include "compositor.hpp"
+#include "event_loop.hpp"
 #include "events.hpp"
+#include "gfx/glyph_atlas.hpp"
+#include "gfx/sprite_cache.hpp"
 
 namespace pwswd {
 
@@ -36,16 +46,49 @@ namespace pwswd {
         OverlayManager() {
             this->m_currOverlay = { OverlayType::None, 0, 0 };
             this->m_framebuffer = nullptr;
+            this->m_notifier = nullptr;
         }
 
-        void initialize(pwswd::dev::Framebuffer *framebuffer) {
+        void initialize(pwswd::dev::Framebuffer *framebuffer, pwswd::Notifier *notifier) {
             this->m_framebuffer = framebuffer;
+            this->m_notifier = notifier;
+            this->m_compositor.initialize(framebuffer);
         }
 
+        /**
+         * Shows an overlay once the ones before it timed out. Can be called from any thread. An overlay of a
+         * type that's already visible or waiting replaces its value and timeout instead of queueing up again.
+         */
         void enqueueOverlay(Overlay overlay) {
-            this->m_overlayQueue.push(overlay);
+            if (overlay.type == OverlayType::None)
+                return;
+
+            this->m_enqueueCount.fetch_add(1, std::memory_order_relaxed);
+
+            // Only the first update since the renderer last looked queues the type, later ones just replace the value
+            auto previous = this->m_pendingOverlays[std::size_t(overlay.type)].exchange(packOverlay(overlay), std::memory_order_acq_rel);
+            if ((previous & PendingFlag) == 0)
+                this->m_pendingTypes.push(overlay.type);
+
+            // Wake up the renderer, it sleeps as long as no overlay is active
+            if (this->m_notifier != nullptr)
+                this->m_notifier->notify();
+        }
+
+        [[nodiscard]] std::uint64_t getEnqueueCount() const {
+            return this->m_enqueueCount.load(std::memory_order_relaxed);
         }
 
+        [[nodiscard]] bool isActive() {
+            return !this->m_pendingTypes.empty() || this->m_waitingCount > 0 || this->m_currOverlay.type != OverlayType::None || this->m_compositor.isDirty();
+        }
+
+        // Removes everything that's been drawn from a copy of the visible page, e.g. for screenshots
+        void removeFromSnapshot(const pwswd::gfx::Surface &snapshot) {
+            this->m_compositor.restoreInto(snapshot);
+        }
+
+        // Restarts the visible overlay's timeout, only to be called from the rendering thread
         void renewOverlay(std::uint32_t newTimeoutMs = 0) {
             if (this->m_currOverlay.type == OverlayType::None)
                 return;
@@ -55,6 +98,10 @@ namespace pwswd {
 
             if (newTimeoutMs > 0)
                 this->m_currOverlay.timeoutMs = newTimeoutMs;
+
+            // Wake up the renderer in case it already went to sleep
+            if (this->m_notifier != nullptr)
+                this->m_notifier->notify();
         }
 
         void render() {
@@ -62,12 +109,14 @@ namespace pwswd {
             if (this->m_framebuffer == nullptr)
                 return;
 
-            // Nothing to render if no overlay is in queue or currently visible
-            if (this->m_overlayQueue.empty() && this->m_currOverlay.type == OverlayType::None)
+            this->collectPendingOverlays();
+
+            // Nothing to render if no overlay is in queue or currently visible and nothing needs to be restored
+            if (this->m_waitingCount == 0 && this->m_currOverlay.type == OverlayType::None && !this->m_compositor.isDirty())
                 return;
 
             // If there's currently no overlay visible but the queue isn't empty, dequeue the oldest one
-            if (this->m_currOverlay.type == OverlayType::None) {
+            if (this->m_currOverlay.type == OverlayType::None && this->m_waitingCount > 0) {
                 this->dequeueOverlay();
             }
 
@@ -80,32 +129,256 @@ namespace pwswd {
             if (ellapsedTime >= (this->m_currOverlay.timeoutMs * 1E3))
                 this->m_currOverlay = { OverlayType::None, 0, 0 };
 
+            // The overlay's position only changes with the resolution, cached sprites are only valid for one format and size
+            this->updateGeometry();
+
             // Render overlays
-            switch (this->m_currOverlay.type) {
-                case OverlayType::VolumeSlider:
-                    this->m_framebuffer->drawRect(0, 0, 50, 50, 0xFF0000FF);
-                    break;
-                case OverlayType::BrightnessSlider:
-                    this->m_framebuffer->drawRect(0, 0, 50, 50, 0x00FF00FF);
-                    break;
-                default: break;
+            this->m_rects.clear();
+
+            if (this->m_currOverlay.type != OverlayType::None && !this->m_overlayRect.empty())
+                this->m_rects.push_back(this->m_overlayRect);
+
+            // Restore whatever the previous frame drew outside of this one, then draw over the backed up area
+            this->m_compositor.prepare(this->m_rects);
+
+            if (this->m_rects.empty())
+                return;
+
+            const auto &rect = this->m_rects.front();
+            auto surface = this->m_framebuffer->getVisibleSurface().getSubSurface(rect.x, rect.y, rect.w, rect.h);
+
+            auto sprite = this->getSprite(this->m_currOverlay);
+            if (sprite == nullptr)
+                return;
+
+            if (sprite->opaque) {
+                pwswd::gfx::blit(surface, sprite->pixels);
+                return;
             }
+
+            // Translucent sprites are blended over the game's latest pixels. Where the game didn't draw since the last
+            // frame the page still shows the overlay, those pixels come from the backup so it isn't blended with itself
+            auto background = this->m_compositor.refreshBackup(rect);
+            this->m_framebuffer->withPixelFormat([&](auto format) {
+                pwswd::gfx::blendBlit<decltype(format)>(surface, background, sprite->pixels, sprite->alpha);
+            });
+
+            this->m_compositor.commit(rect);
         }
 
     private:
+        static constexpr std::uint32_t OverlayX = (pwswd::dev::Framebuffer::ScreenWidth - pwswd::dev::Framebuffer::OverlayWidth) / 2;
+        static constexpr std::uint32_t OverlayY = pwswd::dev::Framebuffer::ScreenHeight - pwswd::dev::Framebuffer::OverlayHeight - 20;
+
+        static constexpr std::size_t OverlayTypeCount = std::size_t(OverlayType::ScreenshotPopup) + 1;
+
+        // Every type is queued at most once at a time
+        static constexpr std::size_t PendingQueueSize = 16;
+        static_assert(PendingQueueSize >= OverlayTypeCount);
+
+        static constexpr std::uint64_t PendingFlag = 1ULL << 63;
+        static constexpr std::uint32_t MaxTimeoutMs = 0x7FFF'FFFF;
+
+        // Enough for every slider step at 320x240 in 16 bit, a handful of sprites at 640x480 in 32 bit
+        static constexpr std::size_t SpriteCacheSize = 256 * 1024;
+
+        // The alpha atlas is never confused with a real format, index 0 is std::monostate
+        static constexpr std::size_t AlphaFormatId = 0;
+
+        static constexpr std::uint32_t BackgroundColor  = 0x202020C0;
+        static constexpr std::uint32_t TextColor        = 0xFFFFFFFF;
+        static constexpr std::uint32_t TextShadowColor  = 0x000000FF;
+        static constexpr std::uint32_t SliderTrackColor = 0x505050C0;
+        static constexpr std::uint32_t SliderFillColor  = 0x3080F0FF;
+
         timeval m_startTime;
 
         Overlay m_currOverlay;
-        std::queue<Overlay> m_overlayQueue;
+
+        // Latest value and timeout per type with a flag telling if the renderer has yet to pick them up, packed so
+        // they're published in one store. Types appear in the queue in the order they first got pending
+        std::array<std::atomic<std::uint64_t>, OverlayTypeCount> m_pendingOverlays = { };
+        pwswd::BoundedQueue<OverlayType, PendingQueueSize> m_pendingTypes;
+        std::atomic<std::uint64_t> m_enqueueCount = 0;
+
+        // Overlays the renderer picked up that wait for the visible one to time out, oldest first
+        std::array<Overlay, OverlayTypeCount> m_waitingOverlays;
+        std::size_t m_waitingCount = 0;
 
         pwswd::dev::Framebuffer *m_framebuffer;
+        pwswd::Notifier *m_notifier;
+
+        pwswd::Compositor m_compositor;
+        std::vector<pwswd::dev::Rect> m_rects;
+
+        pwswd::gfx::GlyphAtlas m_glyphAtlas, m_alphaAtlas;
+        pwswd::gfx::SpriteCache m_spriteCache{ SpriteCacheSize };
+
+        std::uint32_t m_xres = 0, m_yres = 0;
+        std::size_t m_formatId = 0;
+        pwswd::dev::Rect m_overlayRect = { 0, 0, 0, 0 };
+
+        static bool isSlider(OverlayType type) {
+            return type == OverlayType::VolumeSlider || type == OverlayType::BrightnessSlider || type == OverlayType::SharpnessSlider;
+        }
+
+        static const char* getLabel(const Overlay &overlay) {
+            switch (overlay.type) {
+                case OverlayType::VolumeSlider:     return "VOLUME";
+                case OverlayType::BrightnessSlider: return "BRIGHTNESS";
+                case OverlayType::SharpnessSlider:  return "SHARPNESS";
+                case OverlayType::AspectRatioPopup:
+                    switch (overlay.value) {
+                        case 0:  return "FULLSCREEN";
+                        case 1:  return "KEEP ASPECT";
+                        case 2:  return "INTEGER SCALING";
+                        default: return "INTEGER ASPECT";
+                    }
+                case OverlayType::MutePopup:        return "MUTED";
+                case OverlayType::HeadphonesPopup:  return overlay.value ? "HEADPHONES ON" : "HEADPHONES OFF";
+                case OverlayType::MouseModePopup:
+                    switch (static_cast<pwswd::MouseMode>(overlay.value)) {
+                        case pwswd::MouseMode::LeftJoyStick:  return "MOUSE: LEFT STICK";
+                        case pwswd::MouseMode::RightJoyStick: return "MOUSE: RIGHT STICK";
+                        default:                              return "MOUSE MODE OFF";
+                    }
+                case OverlayType::JoystickModePopup: return "JOYSTICK MODE";
+                case OverlayType::ScreenshotPopup:  return overlay.value ? "SCREENSHOT SAVED" : "SCREENSHOT FAILED";
+                default:                            return "";
+            }
+        }
+
+        void updateGeometry() {
+            auto [xres, yres] = this->m_framebuffer->getResolution();
+            auto formatId = this->m_framebuffer->getPixelFormat().index();
+
+            if (xres == this->m_xres && yres == this->m_yres && formatId == this->m_formatId)
+                return;
+
+            this->m_xres = xres;
+            this->m_yres = yres;
+            this->m_formatId = formatId;
+
+            this->m_overlayRect = this->m_framebuffer->clipRect(this->m_framebuffer->scaleRect(OverlayX, OverlayY, pwswd::dev::Framebuffer::OverlayWidth, pwswd::dev::Framebuffer::OverlayHeight));
+            this->m_spriteCache.clear();
+        }
+
+        // Sliders only ever show whole percentages, so there's at most 101 different sprites per slider
+        static std::uint64_t getSpriteKey(const Overlay &overlay) {
+            std::uint32_t value = isSlider(overlay.type) ? std::min<std::uint32_t>(overlay.value, 100) : overlay.value;
+
+            return (std::uint64_t(overlay.type) << 32) | value;
+        }
+
+        // Looks up the overlay's sprite, rendering it first if it isn't cached yet
+        const pwswd::gfx::Sprite* getSprite(const Overlay &overlay) {
+            // Nothing can be drawn in a format we don't know
+            if (std::holds_alternative<std::monostate>(this->m_framebuffer->getPixelFormat()))
+                return nullptr;
+
+            const auto key = getSpriteKey(overlay);
+            if (auto sprite = this->m_spriteCache.find(key); sprite != nullptr)
+                return sprite;
+
+            auto &sprite = this->m_spriteCache.insert(key, this->m_overlayRect.w, this->m_overlayRect.h, this->m_framebuffer->getStride());
+
+            // Text is scaled with the resolution, the atlases get rebuilt whenever the format or the scale changes
+            const std::uint8_t scale = std::max<std::uint32_t>(this->m_yres / 240, 1);
+
+            // Resolve the pixel format once for the whole overlay. The same drawing code fills the alpha values, in a format that only has alpha
+            this->m_framebuffer->withPixelFormat([&](auto format) {
+                using Format = decltype(format);
+
+                if (!this->m_glyphAtlas.isBuiltFor(this->m_formatId, scale))
+                    this->m_glyphAtlas.template build<Format>(this->m_formatId, scale, TextColor, TextShadowColor);
+                if (!this->m_alphaAtlas.isBuiltFor(AlphaFormatId, scale))
+                    this->m_alphaAtlas.template build<pwswd::gfx::Alpha8>(AlphaFormatId, scale, TextColor, TextShadowColor);
+
+                this->drawOverlay<Format>(sprite.pixels, overlay, this->m_glyphAtlas, scale);
+                this->drawOverlay<pwswd::gfx::Alpha8>(sprite.alpha, overlay, this->m_alphaAtlas, scale);
+            });
+
+            const auto alphaValues = sprite.alpha.data, alphaEnd = alphaValues + std::size_t(sprite.alpha.width) * sprite.alpha.height;
+            sprite.opaque = std::all_of(alphaValues, alphaEnd, [](std::uint8_t alpha) { return alpha == 0xFF; });
+
+            return &sprite;
+        }
+
+        template<typename Format>
+        void drawOverlay(const pwswd::gfx::Surface &surface, const Overlay &overlay, const pwswd::gfx::GlyphAtlas &atlas, std::uint8_t scale) {
+            const std::uint32_t padding = 3 * scale;
+            const std::uint32_t textHeight = atlas.getTextHeight();
+
+            pwswd::gfx::fillRect<Format>(surface, 0, 0, surface.width, surface.height, BackgroundColor);
+
+            if (isSlider(overlay.type)) {
+                // Label on the left and value on the right in the top row, bar underneath
+                char valueString[8];
+                snprintf(valueString, sizeof(valueString), "%u%%", std::min<std::uint32_t>(overlay.value, 100));
+
+                atlas.drawText(surface, padding, padding, getLabel(overlay));
+
+                std::uint32_t valueWidth = atlas.getTextWidth(valueString);
+                if (valueWidth + padding <= surface.width)
+                    atlas.drawText(surface, surface.width - valueWidth - padding, padding, valueString);
+
+                const std::uint32_t barY = padding * 2 + textHeight;
+                if (barY + padding >= surface.height || surface.width <= padding * 2)
+                    return;
+
+                const std::uint32_t barWidth = surface.width - padding * 2;
+                const std::uint32_t barHeight = surface.height - barY - padding;
+                const std::uint32_t filledWidth = (barWidth * std::min<std::uint32_t>(overlay.value, 100)) / 100;
+
+                pwswd::gfx::fillRect<Format>(surface, padding, barY, filledWidth, barHeight, SliderFillColor);
+                pwswd::gfx::fillRect<Format>(surface, padding + filledWidth, barY, barWidth - filledWidth, barHeight, SliderTrackColor);
+            } else {
+                // Popups only show their text, centered
+                const char *label = getLabel(overlay);
+                std::uint32_t textWidth = atlas.getTextWidth(label);
+
+                atlas.drawText(surface, textWidth < surface.width ? (surface.width - textWidth) / 2 : 0, textHeight < surface.height ? (surface.height - textHeight) / 2 : 0, label);
+            }
+        }
+
+        static std::uint64_t packOverlay(const Overlay &overlay) {
+            return PendingFlag | (std::uint64_t(std::min(overlay.timeoutMs, MaxTimeoutMs)) << 32) | overlay.value;
+        }
+
+        static Overlay unpackOverlay(OverlayType type, std::uint64_t packed) {
+            return { type, std::uint32_t(packed), std::uint32_t(packed >> 32) & MaxTimeoutMs };
+        }
+
+        // Moves everything that got enqueued since the last frame to the visible or waiting overlays
+        void collectPendingOverlays() {
+            while (auto type = this->m_pendingTypes.pop()) {
+                auto overlay = unpackOverlay(*type, this->m_pendingOverlays[std::size_t(*type)].exchange(0, std::memory_order_acq_rel));
+
+                // Update the visible overlay in place and let it stay for another full timeout
+                if (overlay.type == this->m_currOverlay.type) {
+                    this->m_currOverlay = overlay;
+                    gettimeofday(std::addressof(this->m_startTime), nullptr);
+                    continue;
+                }
+
+                auto waitingEnd = this->m_waitingOverlays.begin() + this->m_waitingCount;
+                auto waiting = std::find_if(this->m_waitingOverlays.begin(), waitingEnd, [&](const Overlay &other) { return other.type == overlay.type; });
+
+                if (waiting != waitingEnd)
+                    *waiting = overlay;
+                else
+                    this->m_waitingOverlays[this->m_waitingCount++] = overlay;
+            }
+        }
 
         void dequeueOverlay() {
             if (gettimeofday(std::addressof(this->m_startTime), nullptr) != 0)
                 return;
 
-            this->m_currOverlay = this->m_overlayQueue.front();
-            this->m_overlayQueue.pop();
+            this->m_currOverlay = this->m_waitingOverlays.front();
+
+            std::move(this->m_waitingOverlays.begin() + 1, this->m_waitingOverlays.begin() + this->m_waitingCount, this->m_waitingOverlays.begin());
+            this->m_waitingCount--;
         }
     };
 
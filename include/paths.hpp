@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+namespace pwswd {
+
+    /**
+     * Locations of all devices and files the daemon uses. Each of them can be overridden through
+     * an environment variable, so the daemon can be pointed at stand-ins on a workstation.
+     */
+    struct Paths {
+        std::string buttonDevice;
+        std::string joystickDevice;
+        std::string framebufferDevice;
+        std::string consoleDevice;
+        std::string uinputDevice;
+        std::string mixerDevice;
+        std::string sysfsRoot;
+        std::string procRoot;
+        std::string calibrationFile;
+        std::string configFile;
+        std::string screenshotDirectory;
+
+        [[nodiscard]] static Paths fromEnvironment() {
+            return {
+                getEnvironment("PWSWDPP_BUTTON_DEVICE",        "/dev/input/event0"),
+                getEnvironment("PWSWDPP_JOYSTICK_DEVICE",      "/dev/input/event3"),
+                getEnvironment("PWSWDPP_FRAMEBUFFER_DEVICE",   "/dev/fb0"),
+                getEnvironment("PWSWDPP_CONSOLE_DEVICE",       "/dev/tty1"),
+                getEnvironment("PWSWDPP_UINPUT_DEVICE",        "/dev/uinput"),
+                getEnvironment("PWSWDPP_MIXER_DEVICE",         "/dev/snd/controlC0"),
+                getEnvironment("PWSWDPP_SYSFS_ROOT",           "/sys"),
+                getEnvironment("PWSWDPP_PROC_ROOT",            "/proc"),
+                getEnvironment("PWSWDPP_CALIBRATION_FILE",     "/media/data/local/home/.pwswdpp_calibration"),
+                getEnvironment("PWSWDPP_CONFIG_FILE",          "/media/data/local/home/.pwswdpp.conf"),
+                getEnvironment("PWSWDPP_SCREENSHOT_DIRECTORY", "/media/sdcard/screenshots")
+            };
+        }
+
+    private:
+        [[nodiscard]] static std::string getEnvironment(const char *name, const char *defaultValue) {
+            const char *value = std::getenv(name);
+
+            return value != nullptr && value[0] != '\0' ? value : defaultValue;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include "event_loop.hpp"
+
+namespace pwswd {
+
+    struct PointerStatistics {
+        std::uint64_t ticks;
+        std::uint64_t activeTime;
+        std::uint64_t totalJitter;
+        std::uint32_t maxJitter;
+    };
+
+    /**
+     * Turns joystick displacement into cursor movement. Speeds come from a response curve that's
+     * precomputed for every raw displacement, and are integrated over the time that actually
+     * passed between two ticks in fixed point, so slow speeds still move the cursor by a pixel
+     * every now and then. The tick timer only runs while the stick is outside the dead zone and
+     * ticks about once per pixel at slow speeds, up to MaxTickRate when moving fast. Once it's
+     * stopped it stays disarmed until the next displacement past the dead zone.
+     */
+    class PointerEngine {
+    public:
+        PointerEngine() : m_timer(nullptr) { }
+
+        void initialize(pwswd::Timer *timer) {
+            this->m_timer = timer;
+        }
+
+        // Sets the displacement of both axes past the dead zone in raw units and (re)arms the tick timer accordingly
+        void setDisplacement(std::int32_t x, std::int32_t y) {
+            this->m_velocityX = getVelocity(x);
+            this->m_velocityY = getVelocity(y);
+
+            if (this->m_velocityX == 0 && this->m_velocityY == 0) {
+                this->stop();
+                return;
+            }
+
+            // The stick's readings are noisy, only restart the timer once the rate changed noticeably
+            const auto interval = this->getTickInterval();
+            if (this->m_timer->isArmed() && std::abs(std::int32_t(interval) - std::int32_t(this->m_tickInterval)) * 4 < std::int32_t(this->m_tickInterval))
+                return;
+
+            // Movement is integrated over the time since the last tick, so restarting the timer doesn't lose any
+            const auto now = pwswd::getMonotonicTime();
+            if (!this->m_timer->isArmed())
+                this->m_lastTick = now;
+
+            this->m_nextTick = now + interval;
+            this->m_tickInterval = interval;
+            this->m_timer->arm(interval);
+        }
+
+        // Call whenever the tick timer expired, returns the number of pixels to move the cursor by
+        [[nodiscard]] std::pair<std::int32_t, std::int32_t> tick() {
+            // An expiration that was already pending when the engine got stopped, don't keep the timer running for it
+            if (this->m_velocityX == 0 && this->m_velocityY == 0) {
+                this->stop();
+                return { 0, 0 };
+            }
+
+            const auto now = pwswd::getMonotonicTime();
+            const auto elapsed = std::min<std::uint64_t>(now - this->m_lastTick, MaxTickInterval * 2);
+
+            // How late this tick is compared to when it was due
+            const std::uint32_t jitter = now > this->m_nextTick ? now - this->m_nextTick : this->m_nextTick - now;
+            this->m_statistics.ticks++;
+            this->m_statistics.activeTime += elapsed;
+            this->m_statistics.totalJitter += jitter;
+            this->m_statistics.maxJitter = std::max(this->m_statistics.maxJitter, jitter);
+
+            // Follow the timer's schedule, unless ticks were missed altogether
+            this->m_lastTick = now;
+            this->m_nextTick += this->m_tickInterval;
+            if (this->m_nextTick <= now)
+                this->m_nextTick = now + this->m_tickInterval;
+
+            return { advance(this->m_remainderX, this->m_velocityX, elapsed), advance(this->m_remainderY, this->m_velocityY, elapsed) };
+        }
+
+        void stop() {
+            this->m_velocityX = 0;
+            this->m_velocityY = 0;
+            this->m_remainderX = 0;
+            this->m_remainderY = 0;
+            this->m_tickInterval = 0;
+
+            if (this->m_timer != nullptr)
+                this->m_timer->disarm();
+        }
+
+        [[nodiscard]] const PointerStatistics& getStatistics() const {
+            return this->m_statistics;
+        }
+
+    private:
+        // Speeds are in 1/256 pixels per second
+        static constexpr std::uint8_t FractionBits = 8;
+
+        // Displacement past the dead zone at which the cursor reaches full speed
+        static constexpr std::int32_t MaxDisplacement = 1650;
+        static constexpr std::uint32_t MinSpeed = 20 << FractionBits;
+        static constexpr std::uint32_t MaxSpeed = 800 << FractionBits;
+
+        static constexpr std::uint32_t MaxTickRate = 125;
+        static constexpr std::uint32_t MinTickInterval = 1'000'000 / MaxTickRate;
+        static constexpr std::uint32_t MaxTickInterval = 50'000;
+
+        // Quadratic curve from MinSpeed right outside the dead zone to MaxSpeed at full displacement, fine control near the center
+        static constexpr std::array<std::uint32_t, MaxDisplacement + 1> ResponseCurve = [] {
+            std::array<std::uint32_t, MaxDisplacement + 1> curve = { };
+
+            for (std::uint64_t displacement = 1; displacement <= MaxDisplacement; displacement++)
+                curve[displacement] = MinSpeed + ((MaxSpeed - MinSpeed) * displacement * displacement) / (std::uint64_t(MaxDisplacement) * MaxDisplacement);
+
+            return curve;
+        }();
+
+        pwswd::Timer *m_timer;
+
+        std::int32_t m_velocityX = 0, m_velocityY = 0;
+        std::int64_t m_remainderX = 0, m_remainderY = 0;
+
+        std::uint32_t m_tickInterval = 0;
+        std::uint64_t m_lastTick = 0, m_nextTick = 0;
+
+        PointerStatistics m_statistics = { 0 };
+
+        [[nodiscard]] static std::int32_t getVelocity(std::int32_t displacement) {
+            const auto speed = ResponseCurve[std::min(std::abs(displacement), MaxDisplacement)];
+
+            return displacement < 0 ? -std::int32_t(speed) : std::int32_t(speed);
+        }
+
+        // Tick about once per pixel along the faster axis
+        [[nodiscard]] std::uint32_t getTickInterval() const {
+            const std::uint64_t speed = std::max(std::abs(this->m_velocityX), std::abs(this->m_velocityY));
+
+            return std::clamp<std::uint64_t>((1'000'000ULL << FractionBits) / speed, MinTickInterval, MaxTickInterval);
+        }
+
+        // Adds the distance travelled to the sub-pixel remainder and takes out the whole pixels
+        [[nodiscard]] static std::int32_t advance(std::int64_t &remainder, std::int32_t velocity, std::uint64_t elapsed) {
+            remainder += (std::int64_t(velocity) * std::int64_t(elapsed)) / 1'000'000;
+
+            const std::int64_t pixels = remainder / (1 << FractionBits);
+            remainder -= pixels * (1 << FractionBits);
+
+            return pixels;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "devices/framebuffer.hpp"
+#include "event_loop.hpp"
+#include "gfx/image_writer.hpp"
+#include "gfx/pixel_format.hpp"
+#include "gfx/surface.hpp"
+#include "overlay_manager.hpp"
+
+namespace pwswd {
+
+    enum class ImageFormat {
+        PNG,
+        QOI,
+        BMP
+    };
+
+    struct ScreenshotStatistics {
+        std::uint64_t screenshots;
+        std::uint64_t failures;
+        std::uint32_t lastCaptureTime;
+        std::uint32_t maxCaptureTime;
+        std::uint32_t lastEncodeTime;
+        std::uint64_t lastEncodeThroughput;
+        std::uint64_t lastFileSize;
+        std::uint64_t workerCpuTime;
+    };
+
+    /**
+     * Takes screenshots of whatever is being scanned out. The visible page gets copied in one go
+     * while holding the framebuffer lock, everything else happens on a low priority worker thread
+     * that converts and encodes the copy one row at a time. The copy buffer is reused, so memory
+     * use stays at one page plus the encoder's fixed buffers.
+     */
+    class ScreenshotManager {
+    public:
+        ScreenshotManager() : m_framebuffer(nullptr), m_overlayManager(nullptr) { }
+
+        ~ScreenshotManager() {
+            {
+                std::scoped_lock lock(this->m_lock);
+                this->m_running = false;
+            }
+
+            this->m_condition.notify_one();
+
+            if (this->m_worker.joinable())
+                this->m_worker.join();
+        }
+
+        void initialize(pwswd::dev::Framebuffer *framebuffer, pwswd::OverlayManager *overlayManager, std::string directory, ImageFormat format) {
+            this->m_framebuffer = framebuffer;
+            this->m_overlayManager = overlayManager;
+            this->m_directory = std::move(directory);
+            this->m_format = format;
+
+            this->m_running = true;
+            this->m_worker = std::thread([this] { this->processScreenshots(); });
+        }
+
+        /**
+         * Copies the visible page and hands it to the worker. Has to be called from the thread that renders overlays.
+         * Returns false if the previous screenshot is still being saved or there's nothing to capture.
+         */
+        bool capture() {
+            std::unique_lock lock(this->m_lock);
+            if (this->m_pending)
+                return false;
+
+            const auto startTime = pwswd::getMonotonicTime();
+            {
+                std::scoped_lock framebufferLock(*this->m_framebuffer);
+
+                auto page = this->m_framebuffer->getVisibleSurface();
+                if (page.data == nullptr || std::holds_alternative<std::monostate>(this->m_framebuffer->getPixelFormat()))
+                    return false;
+
+                // The whole page including the padding at the end of every row is contiguous, so it's one memcpy
+                const std::size_t size = page.pitch * page.height;
+                if (this->m_snapshot.size() < size)
+                    this->m_snapshot.resize(size);
+
+                std::memcpy(this->m_snapshot.data(), page.data, size);
+
+                this->m_snapshotSurface = { this->m_snapshot.data(), page.pitch, page.width, page.height, page.bytesPerPixel };
+                this->m_snapshotFormat = this->m_framebuffer->getPixelFormat();
+            }
+
+            const auto captureTime = std::uint32_t(pwswd::getMonotonicTime() - startTime);
+            this->m_statistics.lastCaptureTime = captureTime;
+            this->m_statistics.maxCaptureTime = std::max(this->m_statistics.maxCaptureTime, captureTime);
+
+            // Overlays shouldn't end up in the screenshot
+            this->m_overlayManager->removeFromSnapshot(this->m_snapshotSurface);
+
+            this->m_pending = true;
+            lock.unlock();
+            this->m_condition.notify_one();
+
+            return true;
+        }
+
+        [[nodiscard]] ScreenshotStatistics getStatistics() {
+            std::scoped_lock lock(this->m_lock);
+            return this->m_statistics;
+        }
+
+    private:
+        static constexpr int WorkerNiceness = 19;
+        static constexpr std::size_t FileBufferSize = 64 * 1024;
+        static constexpr std::uint32_t ScreenshotPopupTimeout = 1500;
+
+        pwswd::dev::Framebuffer *m_framebuffer;
+        pwswd::OverlayManager *m_overlayManager;
+        std::string m_directory;
+        ImageFormat m_format = ImageFormat::PNG;
+
+        std::thread m_worker;
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        bool m_running = false;
+        bool m_pending = false;
+
+        // Only touched by the worker while a screenshot is pending
+        std::vector<std::uint8_t> m_snapshot;
+        pwswd::gfx::Surface m_snapshotSurface = { nullptr, 0, 0, 0, 0 };
+        pwswd::gfx::AnyPixelFormat m_snapshotFormat;
+
+        ScreenshotStatistics m_statistics = { 0 };
+
+        void processScreenshots() {
+            // Saving a screenshot is never urgent, leave the CPU to the game
+            setpriority(PRIO_PROCESS, syscall(SYS_gettid), WorkerNiceness);
+
+            std::unique_lock lock(this->m_lock);
+
+            while (true) {
+                this->m_condition.wait(lock, [this] { return this->m_pending || !this->m_running; });
+
+                if (!this->m_running)
+                    return;
+
+                lock.unlock();
+
+                std::uint64_t fileSize = 0;
+                const auto startTime = pwswd::getMonotonicTime();
+                const bool success = this->save(fileSize);
+                const auto encodeTime = std::max<std::uint64_t>(pwswd::getMonotonicTime() - startTime, 1);
+
+                lock.lock();
+
+                if (success) {
+                    this->m_statistics.screenshots++;
+                    this->m_statistics.lastEncodeTime = encodeTime;
+                    this->m_statistics.lastEncodeThroughput = this->getPixelCount() * 1'000'000 / encodeTime;
+                    this->m_statistics.lastFileSize = fileSize;
+                } else {
+                    this->m_statistics.failures++;
+                }
+
+                this->m_statistics.workerCpuTime = pwswd::getThreadCpuTime();
+
+                this->m_pending = false;
+
+                this->m_overlayManager->enqueueOverlay({ OverlayType::ScreenshotPopup, success, ScreenshotPopupTimeout });
+            }
+        }
+
+        [[nodiscard]] std::uint64_t getPixelCount() const {
+            return std::uint64_t(this->m_snapshotSurface.width) * this->m_snapshotSurface.height;
+        }
+
+        [[nodiscard]] const char* getExtension() const {
+            switch (this->m_format) {
+                case ImageFormat::QOI: return "qoi";
+                case ImageFormat::BMP: return "bmp";
+                default:               return "png";
+            }
+        }
+
+        [[nodiscard]] std::unique_ptr<pwswd::gfx::ImageWriter> createWriter(std::FILE *file) const {
+            switch (this->m_format) {
+                case ImageFormat::QOI: return std::make_unique<pwswd::gfx::QoiWriter>(file);
+                case ImageFormat::BMP: return std::make_unique<pwswd::gfx::BmpWriter>(file);
+                default:               return std::make_unique<pwswd::gfx::PngWriter>(file);
+            }
+        }
+
+        // Picks a file name after the current time that isn't taken yet
+        [[nodiscard]] std::string getFilePath() const {
+            char timeString[32];
+            std::time_t currTime = std::time(nullptr);
+            std::tm localTime;
+            localtime_r(&currTime, &localTime);
+            std::strftime(timeString, sizeof(timeString), "%Y%m%d_%H%M%S", &localTime);
+
+            std::string basePath = this->m_directory + "/screenshot_" + timeString;
+            std::string path = basePath + "." + this->getExtension();
+
+            for (std::uint32_t suffix = 1; access(path.c_str(), F_OK) == 0; suffix++)
+                path = basePath + "_" + std::to_string(suffix) + "." + this->getExtension();
+
+            return path;
+        }
+
+        bool save(std::uint64_t &fileSize) {
+            if (mkdir(this->m_directory.c_str(), 0755) != 0 && errno != EEXIST)
+                return false;
+
+            // Write to a temporary file first so a full SD card doesn't leave a broken image behind
+            const std::string path = this->getFilePath();
+            const std::string temporaryPath = path + ".part";
+
+            std::FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+            if (file == nullptr)
+                return false;
+
+            std::setvbuf(file, nullptr, _IOFBF, FileBufferSize);
+
+            std::visit([&](auto format) {
+                if constexpr (!std::is_same_v<decltype(format), std::monostate>)
+                    this->encode<decltype(format)>(file);
+            }, this->m_snapshotFormat);
+
+            // Make sure the image actually is on the SD card before it's reported as saved
+            bool success = std::fflush(file) == 0 && !std::ferror(file) && fsync(fileno(file)) == 0;
+            fileSize = std::ftell(file);
+            success = std::fclose(file) == 0 && success;
+
+            if (!success || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+                std::remove(temporaryPath.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        template<typename Format>
+        void encode(std::FILE *file) {
+            const auto &snapshot = this->m_snapshotSurface;
+            auto writer = this->createWriter(file);
+
+            std::vector<std::uint8_t> row(snapshot.width * 3);
+
+            writer->begin(snapshot.width, snapshot.height);
+
+            for (std::uint32_t y = 0; y < snapshot.height; y++) {
+                const std::uint8_t *src = snapshot.getPixelAddress(0, y);
+
+                for (std::uint32_t x = 0; x < snapshot.width; x++, src += Format::BytesPerPixel) {
+                    std::uint32_t pixel = 0;
+                    std::memcpy(&pixel, src, Format::BytesPerPixel);
+
+                    const auto color = Format::decode(pixel);
+                    row[x * 3 + 0] = color >> 24;
+                    row[x * 3 + 1] = color >> 16;
+                    row[x * 3 + 2] = color >> 8;
+                }
+
+                writer->writeRow(row.data());
+            }
+
+            writer->end();
+        }
+    };
+
+}
\ No newline at end of file
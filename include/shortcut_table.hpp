@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "events.hpp"
+
+namespace pwswd {
+
+    enum class Action : std::uint8_t {
+        None,
+
+        Home,
+        KillApplication,
+        IncreaseSharpness,
+        DecreaseSharpness,
+        IncreaseBrightness,
+        DecreaseBrightness,
+        ToggleDisplayStyle,
+        Mute,
+        Screenshot,
+        ToggleLeftStickMouse,
+        ToggleRightStickMouse,
+        IncreaseVolume,
+        DecreaseVolume
+    };
+
+    enum class ShortcutLayer : std::uint8_t {
+        Plain,
+        Power
+    };
+
+    /**
+     * Maps every key code to the action it triggers, once with the power button held down and once
+     * without. Lookups are a single index into a flat array. The defaults are built at compile time,
+     * the config file can rebind any button of a layer with lines like "power dpad_up brightness_up".
+     */
+    class ShortcutTable {
+    public:
+        constexpr ShortcutTable() : m_actions() { }
+
+        [[nodiscard]] static constexpr ShortcutTable getDefaults() {
+            ShortcutTable table;
+
+            table.bind(ShortcutLayer::Power, Button::Start,      Action::Home);
+            table.bind(ShortcutLayer::Power, Button::Select,     Action::KillApplication);
+            table.bind(ShortcutLayer::Power, Button::DpadRight,  Action::IncreaseSharpness);
+            table.bind(ShortcutLayer::Power, Button::DpadLeft,   Action::DecreaseSharpness);
+            table.bind(ShortcutLayer::Power, Button::DpadUp,     Action::IncreaseBrightness);
+            table.bind(ShortcutLayer::Power, Button::DpadDown,   Action::DecreaseBrightness);
+            table.bind(ShortcutLayer::Power, Button::VolumeUp,   Action::ToggleDisplayStyle);
+            table.bind(ShortcutLayer::Power, Button::VolumeDown, Action::Mute);
+            table.bind(ShortcutLayer::Power, Button::A,          Action::Screenshot);
+            table.bind(ShortcutLayer::Power, Button::L3,         Action::ToggleLeftStickMouse);
+            table.bind(ShortcutLayer::Power, Button::R3,         Action::ToggleRightStickMouse);
+
+            table.bind(ShortcutLayer::Plain, Button::VolumeUp,   Action::IncreaseVolume);
+            table.bind(ShortcutLayer::Plain, Button::VolumeDown, Action::DecreaseVolume);
+
+            return table;
+        }
+
+        // Binds by the names used in the config file, returns false if any of them is unknown
+        [[nodiscard]] bool bind(std::string_view layerName, std::string_view buttonName, std::string_view actionName) {
+            ShortcutLayer layer;
+            Button button;
+            Action action;
+
+            if (!parseLayer(layerName, layer) || !parseButton(buttonName, button) || !parseAction(actionName, action))
+                return false;
+
+            this->bind(layer, button, action);
+            return true;
+        }
+
+        constexpr void bind(ShortcutLayer layer, Button button, Action action) {
+            this->m_actions[getIndex(layer, static_cast<std::uint16_t>(button))] = action;
+        }
+
+        [[nodiscard]] constexpr Action lookup(ShortcutLayer layer, std::uint16_t code) const {
+            if (code >= KeyCount)
+                return Action::None;
+
+            return this->m_actions[getIndex(layer, code)];
+        }
+
+    private:
+        static constexpr std::uint16_t KeyCount = static_cast<std::uint16_t>(Button::MouseMiddle) + 1;
+        static constexpr std::uint8_t LayerCount = 2;
+
+        template<typename T>
+        struct Name {
+            std::string_view name;
+            T value;
+        };
+
+        static constexpr Name<ShortcutLayer> LayerNames[] = {
+            { "plain", ShortcutLayer::Plain },
+            { "power", ShortcutLayer::Power }
+        };
+
+        static constexpr Name<Button> ButtonNames[] = {
+            { "select", Button::Select },         { "start", Button::Start },
+            { "a", Button::A },                   { "b", Button::B },
+            { "x", Button::X },                   { "y", Button::Y },
+            { "l1", Button::L1 },                 { "l2", Button::L2 },
+            { "l3", Button::L3 },                 { "r1", Button::R1 },
+            { "r2", Button::R2 },                 { "r3", Button::R3 },
+            { "dpad_up", Button::DpadUp },        { "dpad_down", Button::DpadDown },
+            { "dpad_left", Button::DpadLeft },    { "dpad_right", Button::DpadRight },
+            { "volume_up", Button::VolumeUp },    { "volume_down", Button::VolumeDown }
+        };
+
+        static constexpr Name<Action> ActionNames[] = {
+            { "none", Action::None },
+            { "home", Action::Home },
+            { "kill_application", Action::KillApplication },
+            { "sharpness_up", Action::IncreaseSharpness },
+            { "sharpness_down", Action::DecreaseSharpness },
+            { "brightness_up", Action::IncreaseBrightness },
+            { "brightness_down", Action::DecreaseBrightness },
+            { "display_style", Action::ToggleDisplayStyle },
+            { "mute", Action::Mute },
+            { "screenshot", Action::Screenshot },
+            { "left_stick_mouse", Action::ToggleLeftStickMouse },
+            { "right_stick_mouse", Action::ToggleRightStickMouse },
+            { "volume_up", Action::IncreaseVolume },
+            { "volume_down", Action::DecreaseVolume }
+        };
+
+        std::array<Action, LayerCount * KeyCount> m_actions;
+
+        [[nodiscard]] static constexpr std::size_t getIndex(ShortcutLayer layer, std::uint16_t code) {
+            return static_cast<std::size_t>(layer) * KeyCount + code;
+        }
+
+        template<typename T, std::size_t Size>
+        [[nodiscard]] static bool parseName(const Name<T> (&names)[Size], std::string_view name, T &value) {
+            for (const auto &entry : names) {
+                if (entry.name == name) {
+                    value = entry.value;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        [[nodiscard]] static bool parseLayer(std::string_view name, ShortcutLayer &layer) {
+            return parseName(LayerNames, name, layer);
+        }
+
+        [[nodiscard]] static bool parseButton(std::string_view name, Button &button) {
+            return parseName(ButtonNames, name, button);
+        }
+
+        [[nodiscard]] static bool parseAction(std::string_view name, Action &action) {
+            return parseName(ActionNames, name, action);
+        }
+    };
+
+    // Built into the binary, so starting without a config file doesn't cost anything
+    inline constexpr ShortcutTable DefaultShortcuts = ShortcutTable::getDefaults();
+
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "devices/event_poller.hpp"
+#include "events.hpp"
+
+namespace pwswd {
+
+    struct AxisCalibration {
+        // Fixed point with CalibrationFractionBits fractional bits, so slow drift still moves them
+        std::int32_t center;
+        std::int32_t deviation;
+
+        std::int32_t deadZone;
+        std::int32_t minimum, maximum;
+        std::uint32_t restSamples;
+
+        // Where the stick settled and since when, in microseconds
+        std::int32_t settleValue;
+        std::uint64_t settleTime;
+    };
+
+    /**
+     * Learns where each joystick axis rests and how noisy it is while resting. Samples inside the
+     * dead zone count as resting once the stick stayed within a small window around the same spot
+     * for a while, they move the center and the average deviation from it a little, so a drifting
+     * stick gets followed over time. A thumb moving the stick, or holding it just past the dead
+     * zone for slow cursor movement, never gets learned. The dead zone is derived from the noise
+     * instead of being sized for the worst stick out there. Learned values are stored in a small
+     * text file so a restart doesn't have to learn them again.
+     */
+    class StickCalibrator {
+    public:
+        explicit StickCalibrator(std::string path) : m_path(std::move(path)) {
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++) {
+                std::int32_t center = (axis == std::uint16_t(RelativeAxis::AxisY) || axis == std::uint16_t(RelativeAxis::AxisRY)) ? JoyStickYAxisCenter : JoyStickXAxisCenter;
+
+                this->m_axes[axis] = { center << CalibrationFractionBits, 0, JoyStickDeadZone, 0, 0, 0, center, 0 };
+                resetDeviation(this->m_axes[axis]);
+            }
+        }
+
+        // Picks up the axis ranges from the driver and the centers learned during earlier runs
+        void initialize(pwswd::dev::EventPoller *joystick) {
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++) {
+                auto &calibration = this->m_axes[axis];
+                auto absInfo = joystick->getAbsInfo(axis);
+
+                if (!absInfo.has_value() || absInfo->minimum >= absInfo->maximum)
+                    continue;
+
+                calibration.minimum = absInfo->minimum;
+                calibration.maximum = absInfo->maximum;
+                this->m_minDeadZone[axis] = std::max(MinDeadZone, absInfo->flat);
+            }
+
+            this->load();
+        }
+
+        // Feeds a new reading of an axis taken at the given time in microseconds into the statistics
+        void update(std::uint16_t axis, std::int32_t value, std::uint64_t time) {
+            if (axis >= AxisCount)
+                return;
+
+            auto &calibration = this->m_axes[axis];
+            const std::int32_t scaledValue = value << CalibrationFractionBits;
+            const std::int32_t offset = scaledValue - calibration.center;
+
+            // Anything past the dead zone is the user moving the stick
+            if (std::abs(offset) > calibration.deadZone << CalibrationFractionBits) {
+                calibration.settleTime = 0;
+                return;
+            }
+
+            // Noise stays close to where the stick settled, anything more means it's still being moved. Evdev only
+            // reports changes, so a stick that went quiet counts as settled as well
+            const std::int32_t settleWindow = std::max((calibration.deviation * DeviationFactor) >> CalibrationFractionBits, MinSettleWindow);
+            if (calibration.settleTime == 0 || std::abs(value - calibration.settleValue) > settleWindow) {
+                calibration.settleValue = value;
+                calibration.settleTime = std::max<std::uint64_t>(time, 1);
+                return;
+            }
+
+            if (time - std::min(calibration.settleTime, time) < SettleDuration)
+                return;
+
+            calibration.center += offset / (1 << RestAveragingShift);
+            calibration.deviation += (std::abs(offset) - calibration.deviation) / (1 << RestAveragingShift);
+
+            if (calibration.minimum < calibration.maximum)
+                calibration.center = std::clamp(calibration.center, calibration.minimum << CalibrationFractionBits, calibration.maximum << CalibrationFractionBits);
+
+            // Only trust the noise estimate once enough resting samples came in
+            if (calibration.restSamples < WarmUpSamples) {
+                calibration.restSamples++;
+                return;
+            }
+
+            calibration.deadZone = std::clamp((calibration.deviation * DeviationFactor >> CalibrationFractionBits) + DeadZoneMargin, this->m_minDeadZone[axis], this->getMaxDeadZone(axis));
+        }
+
+        // Distance of a reading from the axis' center past the dead zone, 0 inside of it
+        [[nodiscard]] std::int32_t getDisplacement(std::uint16_t axis, std::int32_t value) const {
+            if (axis >= AxisCount)
+                return 0;
+
+            const auto &calibration = this->m_axes[axis];
+            const std::int32_t offset = value - (calibration.center >> CalibrationFractionBits);
+
+            if (std::abs(offset) <= calibration.deadZone)
+                return 0;
+
+            return offset > 0 ? offset - calibration.deadZone : offset + calibration.deadZone;
+        }
+
+        // Limits how large learned dead zones may get, noisier sticks will drift the cursor a bit instead
+        void setMaxDeadZone(std::int32_t maxDeadZone) {
+            this->m_maxDeadZone = std::max(maxDeadZone, MinDeadZone);
+
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++)
+                this->m_axes[axis].deadZone = std::min(this->m_axes[axis].deadZone, this->getMaxDeadZone(axis));
+        }
+
+        [[nodiscard]] std::int32_t getCenter(std::uint16_t axis) const {
+            return this->getCalibration(axis).center >> CalibrationFractionBits;
+        }
+
+        [[nodiscard]] const AxisCalibration& getCalibration(std::uint16_t axis) const {
+            return this->m_axes[std::min<std::uint16_t>(axis, AxisCount - 1)];
+        }
+
+        // Checks if any axis moved far enough from what's stored to be worth writing again
+        [[nodiscard]] bool isDirty() const {
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++) {
+                const auto &calibration = this->m_axes[axis];
+
+                if (std::abs((calibration.center >> CalibrationFractionBits) - this->m_savedCenters[axis]) >= SaveThreshold || std::abs(calibration.deadZone - this->m_savedDeadZones[axis]) >= SaveThreshold)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool save() {
+            // Write to a temporary file first so a crash can't leave half a calibration behind
+            const std::string temporaryPath = this->m_path + ".tmp";
+
+            std::FILE *file = std::fopen(temporaryPath.c_str(), "w");
+            if (file == nullptr)
+                return false;
+
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++) {
+                const auto &calibration = this->m_axes[axis];
+                std::fprintf(file, "%u %d %d\n", axis, calibration.center >> CalibrationFractionBits, calibration.deadZone);
+            }
+
+            bool success = !std::ferror(file);
+            success = std::fclose(file) == 0 && success;
+
+            if (!success || std::rename(temporaryPath.c_str(), this->m_path.c_str()) != 0) {
+                std::remove(temporaryPath.c_str());
+                return false;
+            }
+
+            for (std::uint16_t axis = 0; axis < AxisCount; axis++) {
+                this->m_savedCenters[axis] = this->m_axes[axis].center >> CalibrationFractionBits;
+                this->m_savedDeadZones[axis] = this->m_axes[axis].deadZone;
+            }
+
+            return true;
+        }
+
+    private:
+        static constexpr std::uint16_t AxisCount = std::uint16_t(RelativeAxis::AxisRY) + 1;
+        static constexpr std::uint8_t CalibrationFractionBits = 8;
+
+        // Every resting sample moves the statistics by 1/64 of its difference
+        static constexpr std::uint8_t RestAveragingShift = 6;
+        static constexpr std::uint32_t WarmUpSamples = 64;
+
+        // A stick has to stay within the range of its noise for this long before it counts as resting
+        static constexpr std::int32_t MinSettleWindow = 8;
+        static constexpr std::uint64_t SettleDuration = 500'000;
+
+        // The average deviation from the center times this plus the margin covers practically all noise
+        static constexpr std::int32_t DeviationFactor = 4;
+        static constexpr std::int32_t DeadZoneMargin = 24;
+        static constexpr std::int32_t MinDeadZone = 48;
+
+        static constexpr std::int32_t SaveThreshold = 4;
+
+        std::string m_path;
+
+        std::array<AxisCalibration, AxisCount> m_axes;
+        std::array<std::int32_t, AxisCount> m_minDeadZone = { MinDeadZone, MinDeadZone, MinDeadZone, MinDeadZone, MinDeadZone };
+        std::int32_t m_maxDeadZone = JoyStickDeadZone;
+        std::array<std::int32_t, AxisCount> m_savedCenters = { 0 }, m_savedDeadZones = { 0 };
+
+        // The driver's flat area wins over a smaller limit
+        [[nodiscard]] std::int32_t getMaxDeadZone(std::uint16_t axis) const {
+            return std::max(this->m_maxDeadZone, this->m_minDeadZone[axis]);
+        }
+
+        // Start out with the noise the current dead zone was made for, so it doesn't shrink while there are only a few samples
+        static void resetDeviation(AxisCalibration &calibration) {
+            calibration.deviation = std::max<std::int32_t>(calibration.deadZone - DeadZoneMargin, 0) / DeviationFactor << CalibrationFractionBits;
+        }
+
+        void load() {
+            std::FILE *file = std::fopen(this->m_path.c_str(), "r");
+            if (file == nullptr)
+                return;
+
+            unsigned axis;
+            std::int32_t center, deadZone;
+            while (std::fscanf(file, "%u %d %d", &axis, &center, &deadZone) == 3) {
+                if (axis >= AxisCount)
+                    continue;
+
+                auto &calibration = this->m_axes[axis];
+
+                // Stored values only count if they are plausible for the stick that's connected now
+                if (calibration.minimum < calibration.maximum && (center < calibration.minimum || center > calibration.maximum))
+                    continue;
+
+                calibration.center = center << CalibrationFractionBits;
+                calibration.deadZone = std::clamp(deadZone, this->m_minDeadZone[axis], this->getMaxDeadZone(axis));
+                resetDeviation(calibration);
+                this->m_savedCenters[axis] = center;
+                this->m_savedDeadZones[axis] = calibration.deadZone;
+            }
+
+            std::fclose(file);
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "devices/framebuffer.hpp"
+#include "event_loop.hpp"
+
+namespace pwswd {
+
+    struct FrameStatistics {
+        std::uint64_t frames;
+        std::uint64_t missedDeadlines;
+        std::uint64_t totalRenderTime;
+        std::uint32_t maxRenderTime;
+        std::uint32_t blankingBudget;
+        bool hardwareVSync;
+    };
+
+    /**
+     * Paces overlay frames to the panel's vertical blank. The frame timer is armed for the vblank
+     * a frame is due at and the frame gets drawn as soon as it expires, the event loop never blocks.
+     * While frames are being drawn a worker thread sits in FBIO_WAITFORVSYNC on the framebuffer's
+     * handle and timestamps every vblank, which keeps the timer in phase with the panel. Drivers
+     * without it get a timer that ticks in multiples of the refresh period instead.
+     *
+     * The worker is parked while the screen is off, a blanked panel doesn't have any vblanks and
+     * some drivers never return from the ioctl then.
+     */
+    class VSyncClock {
+    public:
+        VSyncClock() : m_framebuffer(nullptr), m_timer(nullptr) { }
+
+        ~VSyncClock() {
+            {
+                std::scoped_lock lock(this->m_lock);
+                this->m_running = false;
+            }
+
+            this->m_condition.notify_all();
+
+            // Returns within a refresh period, the worker only ever blocks for a single vblank
+            if (this->m_worker.joinable())
+                this->m_worker.join();
+        }
+
+        void initialize(pwswd::dev::Framebuffer *framebuffer, pwswd::Timer *timer, std::uint32_t maxFrameRate) {
+            this->m_framebuffer = framebuffer;
+            this->m_timer = timer;
+            this->m_maxFrameRate = maxFrameRate;
+
+            if (framebuffer->getVSyncHandle() == -1)
+                return;
+
+            this->m_running = true;
+            this->m_worker = std::thread([this] { this->sampleVBlanks(); });
+        }
+
+        // Picks up refresh timings from the current screen info, call after refreshing it
+        void update() {
+            this->m_refreshPeriod = std::max<std::uint32_t>(this->m_framebuffer->getRefreshPeriod(), 1);
+            this->m_blankingBudget = this->m_framebuffer->getBlankingPeriod();
+
+            // Only draw on every n-th vblank to stay below the maximum frame rate
+            std::uint32_t frameInterval = 1'000'000 / this->m_maxFrameRate;
+            this->m_vblanksPerFrame = std::max<std::uint32_t>((frameInterval + this->m_refreshPeriod - 1) / this->m_refreshPeriod, 1);
+        }
+
+        // Starts pacing from scratch, the first frame is drawn right away and snaps to the panel's vblanks once they're known
+        void start() {
+            this->m_lastVBlank = 0;
+            this->m_hardwareVBlank = 0;
+
+            {
+                std::scoped_lock lock(this->m_lock);
+                this->m_sampling = true;
+            }
+
+            this->m_condition.notify_all();
+            this->m_timer->armAt(getMonotonicTime());
+        }
+
+        // No more frames to draw, lets the worker go back to sleep after the current vblank
+        void stop() {
+            std::scoped_lock lock(this->m_lock);
+            this->m_sampling = false;
+        }
+
+        /**
+         * Parks the worker before the screen gets blanked and the framebuffer closed. Returns once it's out of
+         * its ioctl, which takes at most a refresh period while the panel is still on. Frames keep the timer grid
+         */
+        void suspend() {
+            std::unique_lock lock(this->m_lock);
+            this->m_suspended = true;
+
+            this->m_condition.wait(lock, [this] { return !this->m_waiting; });
+        }
+
+        // Lets the worker sample vblanks again once the framebuffer is reopened and the screen is back on
+        void resume() {
+            {
+                std::scoped_lock lock(this->m_lock);
+                this->m_suspended = false;
+            }
+
+            this->m_condition.notify_all();
+        }
+
+        void scheduleNextFrame() {
+            std::uint64_t target = this->m_lastVBlank + std::uint64_t(this->m_vblanksPerFrame) * this->m_refreshPeriod;
+
+            this->m_timer->armAt(std::max(target, getMonotonicTime()));
+        }
+
+        // Call when the frame timer expired, works out which vblank the frame belongs to without waiting for it
+        void beginFrame() {
+            const std::uint64_t now = getMonotonicTime();
+            const std::uint64_t hardwareVBlank = this->m_hardwareVBlank.load(std::memory_order_relaxed);
+            const std::uint64_t age = now - std::min(hardwareVBlank, now);
+
+            if (hardwareVBlank != 0 && age < MaxVBlankAge * this->m_refreshPeriod) {
+                // The worker may not have timestamped the vblank the timer fired for yet, round to the closest one
+                const std::uint64_t periods = (age + this->m_refreshPeriod / 2) / this->m_refreshPeriod;
+
+                this->m_lastVBlank = hardwareVBlank + periods * this->m_refreshPeriod;
+                this->m_statistics.hardwareVSync = true;
+            } else {
+                // Stay on the refresh period grid so frames don't drift against the panel
+                std::uint64_t expected = this->m_lastVBlank + std::uint64_t(this->m_vblanksPerFrame) * this->m_refreshPeriod;
+
+                if (this->m_lastVBlank == 0 || now >= expected + this->m_refreshPeriod)
+                    this->m_lastVBlank = now;
+                else
+                    this->m_lastVBlank = expected;
+
+                this->m_statistics.hardwareVSync = false;
+            }
+        }
+
+        // Call once the frame was drawn to record whether it made it within the blanking period
+        void endFrame() {
+            const std::uint64_t now = getMonotonicTime();
+            std::uint32_t renderTime = now - std::min(this->m_lastVBlank, now);
+
+            this->m_statistics.frames++;
+            this->m_statistics.totalRenderTime += renderTime;
+            this->m_statistics.maxRenderTime = std::max(this->m_statistics.maxRenderTime, renderTime);
+            this->m_statistics.blankingBudget = this->m_blankingBudget;
+
+            if (renderTime > this->m_blankingBudget)
+                this->m_statistics.missedDeadlines++;
+        }
+
+        [[nodiscard]] const FrameStatistics& getStatistics() const {
+            return this->m_statistics;
+        }
+
+    private:
+        // Vblank timestamps older than this many refresh periods don't say anything about the current phase anymore
+        static constexpr std::uint32_t MaxVBlankAge = 8;
+
+        pwswd::dev::Framebuffer *m_framebuffer;
+        pwswd::Timer *m_timer;
+
+        std::uint32_t m_maxFrameRate = 30;
+        std::uint32_t m_refreshPeriod = 16'667;
+        std::uint32_t m_blankingBudget = 1'000;
+        std::uint32_t m_vblanksPerFrame = 2;
+
+        std::uint64_t m_lastVBlank = 0;
+        std::atomic<std::uint64_t> m_hardwareVBlank = 0;
+
+        std::thread m_worker;
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        bool m_running = false, m_sampling = false, m_suspended = false, m_waiting = false;
+
+        FrameStatistics m_statistics = { 0 };
+
+        void sampleVBlanks() {
+            std::unique_lock lock(this->m_lock);
+
+            while (true) {
+                this->m_condition.wait(lock, [this] { return (this->m_sampling && !this->m_suspended) || !this->m_running; });
+                if (!this->m_running)
+                    break;
+
+                // The handle is only closed and reopened while the worker is suspended, so it's safe to use until then
+                const int handle = this->m_framebuffer->getVSyncHandle();
+                this->m_waiting = true;
+                lock.unlock();
+
+                const bool success = pwswd::dev::Framebuffer::waitForVSync(handle);
+                const int error = errno;
+                if (success)
+                    this->m_hardwareVBlank.store(getMonotonicTime(), std::memory_order_relaxed);
+
+                lock.lock();
+                this->m_waiting = false;
+                this->m_condition.notify_all();
+
+                // Drivers that don't implement it won't start to, the event loop keeps going on the timer grid alone
+                if (!success && error != EINTR)
+                    break;
+            }
+        }
+    };
+
+}
\ No newline at end of file
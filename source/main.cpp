@@ -3,13 +3,28 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <csignal>
+#include <pthread.h>
 #include <cmath>
-#include <map>
-#include <thread>
+#include <array>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 
+#include <sys/signalfd.h>
+
+#include "config_manager.hpp"
 #include "events.hpp"
+#include "event_loop.hpp"
+#include "input_trace.hpp"
+#include "latency_histogram.hpp"
 #include "overlay_manager.hpp"
+#include "paths.hpp"
+#include "pointer_engine.hpp"
+#include "screenshot_manager.hpp"
+#include "stick_calibrator.hpp"
+#include "vsync_clock.hpp"
 
 #include "devices/event_poller.hpp"
 #include "devices/framebuffer.hpp"
@@ -17,119 +32,224 @@
 #include "devices/screen.hpp"
 #include "devices/audio.hpp"
 #include "devices/power.hpp"
+#include "devices/holder_resolver.hpp"
+
+// Has to come first, the devices below are opened at these paths
+static const pwswd::Paths paths = pwswd::Paths::fromEnvironment();
+
+static pwswd::dev::EventPoller buttonEvent(paths.buttonDevice);
+static pwswd::dev::EventPoller joystickEvent(paths.joystickDevice);
 
-static pwswd::dev::EventPoller buttonEvent("/dev/input/event0");
-static pwswd::dev::EventPoller joystickEvent("/dev/input/event3");
+static pwswd::dev::Framebuffer framebuffer(paths.framebufferDevice);
 
-static pwswd::dev::Framebuffer framebuffer("/dev/fb0");
+static pwswd::dev::UInput mouse(paths.uinputDevice, "OpenDingux mouse daemon", { 0x03, 1, 1, 1 });
+static pwswd::dev::Screen screen(paths.sysfsRoot, paths.framebufferDevice);
+static pwswd::dev::Audio audio(paths.mixerDevice);
+static pwswd::dev::Power power(paths.framebufferDevice, paths.consoleDevice);
+static pwswd::dev::HolderResolver holderResolver(paths.procRoot);
 
-static pwswd::dev::UInput mouse("/dev/uinput", "OpenDingux mouse daemon", { 0x03, 1, 1, 1 });
-static pwswd::dev::Screen screen;
-static pwswd::dev::Audio audio;
-static pwswd::dev::Power power;
+static pwswd::EventLoop eventLoop;
+static pwswd::Timer pointerTimer;
+static pwswd::Timer overlayTimer;
+static pwswd::Timer replayTimer;
+static pwswd::Notifier overlayNotifier;
 
 static pwswd::OverlayManager overlayManager;
+static pwswd::VSyncClock vsyncClock;
+static pwswd::ScreenshotManager screenshotManager;
+static pwswd::PointerEngine pointerEngine;
+static pwswd::StickCalibrator stickCalibrator(paths.calibrationFile);
 static pwswd::MouseMode mouseModeState = pwswd::MouseMode::Deactivated;
-static std::mutex mousePositionLock;
-static std::int8_t mouseVelocityX = 0, mouseVelocityY = 0;
-
-void handlePowerShortcut(pwswd::Button button) {
-    switch (button) {
-        case pwswd::Button::Start:
-            mouse.inject(pwswd::createButtonInputEvent(pwswd::Button::Home, pwswd::ButtonState::Pressed));
-            mouse.inject(pwswd::createButtonInputEvent(pwswd::Button::Home, pwswd::ButtonState::Released));
-            mouse.inject(pwswd::createSyncEvent());
+static pwswd::ConfigManager configManager;
+
+// Time from the button press' kernel timestamp until its action is done, per button with and without power held
+struct PendingLatency {
+    pwswd::LatencyHistogram *histogram;
+    std::uint64_t eventTime;
+};
+
+// Indexed by key code, all buttons that can have shortcuts have lower codes than the power button
+static constexpr std::size_t LatencyKeyCount = static_cast<std::size_t>(pwswd::Button::Power);
+// Shortcut presses of a single wakeup, any more than that only lose their samples
+static constexpr std::size_t MaxPendingLatencies = 64;
+
+static std::array<pwswd::LatencyHistogram, LatencyKeyCount> powerShortcutLatencies, shortcutLatencies;
+static std::array<PendingLatency, MaxPendingLatencies> pendingLatencies;
+static std::size_t pendingLatencyCount = 0;
+
+// Input traces are recorded with --record and fed back through the same dispatch code with --replay
+struct Replay {
+    std::unique_ptr<pwswd::TraceReader> reader;
+    std::optional<pwswd::TraceFrame> nextFrame;
+    bool realTime;
+
+    std::uint64_t startTime, clockBase;
+    std::uint64_t frames, events;
+    std::uint64_t uinputFrames, uinputEvents, sysfsWrites, overlays;
+};
+
+static std::unique_ptr<pwswd::TraceWriter> traceWriter;
+static Replay replay;
+
+static constexpr std::uint32_t OverlayFrameRate = 30;
+
+static constexpr auto ScreenshotFormat = pwswd::ImageFormat::PNG;
+
+// Bump whenever names or meanings of the statistics dumped on SIGUSR1 change
+static constexpr std::uint32_t StatisticsVersion = 1;
+
+void stopMouseMovement() {
+    pointerEngine.stop();
+
+    // Mouse mode just ended, a good moment to keep what was learned about the sticks
+    if (stickCalibrator.isDirty())
+        stickCalibrator.save();
+}
+
+void showVolume() {
+    const auto &config = configManager.get();
+
+    // The amixer fallback can't report the volume, don't show a slider with a wrong value then
+    if (auto volume = audio.getVolume(); volume.has_value())
+        overlayManager.enqueueOverlay({ pwswd::OverlayType::VolumeSlider, *volume, config.overlayTimeout });
+}
+
+void toggleMouseMode(pwswd::MouseMode mode) {
+    const auto &config = configManager.get();
+
+    if (mouseModeState == mode) {
+        joystickEvent.ungrab();
+        mouseModeState = pwswd::MouseMode::Deactivated;
+        stopMouseMovement();
+    }
+    else {
+        joystickEvent.grab();
+        mouseModeState = mode;
+    }
+    overlayManager.enqueueOverlay({ pwswd::OverlayType::MouseModePopup, static_cast<std::uint32_t>(mouseModeState), config.overlayTimeout });
+}
+
+void runAction(pwswd::Action action) {
+    const auto &config = configManager.get();
+
+    switch (action) {
+        case pwswd::Action::Home:
+            mouse.queue(pwswd::createButtonInputEvent(pwswd::Button::Home, pwswd::ButtonState::Pressed));
+            mouse.queue(pwswd::createButtonInputEvent(pwswd::Button::Home, pwswd::ButtonState::Released));
+            mouse.flush();
             break;
-        case pwswd::Button::Select:
+        case pwswd::Action::KillApplication:
             power.killForegroundApplication();
             break;
-        case pwswd::Button::DpadRight:
+        case pwswd::Action::IncreaseSharpness:
             screen.increaseSharpness();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::SharpnessSlider, screen.getSharpnessLevel(), config.overlayTimeout });
             break;
-        case pwswd::Button::DpadLeft:
+        case pwswd::Action::DecreaseSharpness:
             screen.decreaseSharpness();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::SharpnessSlider, screen.getSharpnessLevel(), config.overlayTimeout });
             break;
-        case pwswd::Button::DpadUp:
+        case pwswd::Action::IncreaseBrightness:
             screen.increaseBrightness();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::BrightnessSlider, screen.getBrightnessLevel(), config.overlayTimeout });
             break;
-        case pwswd::Button::DpadDown:
+        case pwswd::Action::DecreaseBrightness:
             screen.decreaseBrightness();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::BrightnessSlider, screen.getBrightnessLevel(), config.overlayTimeout });
             break;
-        case pwswd::Button::VolumeUp:
+        case pwswd::Action::ToggleDisplayStyle:
             screen.toggleDisplayStyle();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::AspectRatioPopup, screen.getDisplayStyle(), config.overlayTimeout });
             break;
-        case pwswd::Button::VolumeDown:
+        case pwswd::Action::Mute:
             audio.mute();
+            overlayManager.enqueueOverlay({ pwswd::OverlayType::MutePopup, 0, config.overlayTimeout });
             break;
-        case pwswd::Button::L3:
-            if (mouseModeState == pwswd::MouseMode::LeftJoyStick) {
-                joystickEvent.ungrab();
-                mouseModeState = pwswd::MouseMode::Deactivated;
-            }
-            else {
-                joystickEvent.grab();
-                mouseModeState = pwswd::MouseMode::LeftJoyStick;
-            }
+        case pwswd::Action::Screenshot:
+            screenshotManager.capture();
             break;
-        case pwswd::Button::R3:
-            if (mouseModeState == pwswd::MouseMode::RightJoyStick) {
-                joystickEvent.ungrab();
-                mouseModeState = pwswd::MouseMode::Deactivated;
-            }
-            else {
-                joystickEvent.grab();
-                mouseModeState = pwswd::MouseMode::RightJoyStick;
-            }
+        case pwswd::Action::ToggleLeftStickMouse:
+            toggleMouseMode(pwswd::MouseMode::LeftJoyStick);
             break;
-        default: break;
-    }
-}
-
-void handleShortcuts(pwswd::Button button) {
-    switch (button) {
-        case pwswd::Button::VolumeUp:
-            audio.increase();
+        case pwswd::Action::ToggleRightStickMouse:
+            toggleMouseMode(pwswd::MouseMode::RightJoyStick);
+            break;
+        case pwswd::Action::IncreaseVolume:
+            audio.increase(config.volumeStep);
+            showVolume();
             break;
-        case pwswd::Button::VolumeDown:
-            audio.decrease();
+        case pwswd::Action::DecreaseVolume:
+            audio.decrease(config.volumeStep);
+            showVolume();
             break;
-        default: break;
+        case pwswd::Action::None: break;
     }
 }
 
 
 
 void drawOverlay() {
-    // map the framebuffer into the address space
-    framebuffer.map();
+    eventLoop.countEvents(overlayTimer.acknowledge());
 
-    while (true) {
-        {
-            std::scoped_lock lock(framebuffer);
+    // The timer expired at the vertical blank the frame is due at, drawing right away keeps the overlay from tearing
+    vsyncClock.beginFrame();
 
-            // Refresh variable screen info to detect resolution / bpp changes
-            framebuffer.refreshScreenInfo();
-            // Draw overlays
-            overlayManager.render();
-        }
+    {
+        std::scoped_lock lock(framebuffer);
 
-        usleep(1000);
+        // Refresh variable screen info to follow page flips of the game
+        framebuffer.refreshScreenInfo();
+        overlayManager.render();
     }
+
+    vsyncClock.endFrame();
+
+    // Keep redrawing at a bounded rate so the game can't paint over the overlay until it times out, then go back to sleep
+    if (overlayManager.isActive())
+        vsyncClock.scheduleNextFrame();
+    else
+        vsyncClock.stop();
 }
 
-void calculateMouseMovement() {
-    std::int32_t joystickDisplacementX = 0, joystickDisplacementY = 0;
+void wakeOverlay() {
+    eventLoop.countEvents(overlayNotifier.acknowledge());
 
-    while (true) {
-        joystickEvent.wait();
+    // Already rendering, the renewed or enqueued overlay will be picked up by the next frame
+    if (overlayTimer.isArmed())
+        return;
 
-        auto eventData = joystickEvent.get<pwswd::InputEvent>();
+    {
+        std::scoped_lock lock(framebuffer);
 
-        const auto &type = static_cast<pwswd::EventType>(eventData.type);
+        // Refresh variable screen info to detect resolution / bpp changes and the panel timings
+        framebuffer.refreshScreenInfo();
+        vsyncClock.update();
+    }
 
-        // Don't handle inputs when the screen is off or mouse mode is disabled
-        if (power.isScreenOff() || mouseModeState == pwswd::MouseMode::Deactivated)
-            continue;
+    vsyncClock.start();
+}
+
+void calculateMouseMovement(const pwswd::InputFrame &frame) {
+    static std::int32_t joystickDisplacementX = 0, joystickDisplacementY = 0;
+
+    // Don't handle inputs when the screen is off. Forget the stick's position too, the next event after waking up re-arms the pointer timer
+    if (power.isScreenOff()) {
+        joystickDisplacementX = joystickDisplacementY = 0;
+        pointerEngine.stop();
+        return;
+    }
+
+    // Keep learning the sticks' centers while they're used by games too, so they're calibrated once mouse mode gets enabled
+    for (const auto &eventData : frame) {
+        if (static_cast<pwswd::EventType>(eventData.type) == pwswd::EventType::AbsoluteAxes)
+            stickCalibrator.update(eventData.code, eventData.value, pwswd::toMicroSeconds(eventData.time));
+    }
+
+    if (mouseModeState == pwswd::MouseMode::Deactivated)
+        return;
+
+    for (auto eventData : frame) {
+        const auto &type = static_cast<pwswd::EventType>(eventData.type);
 
         // When mouse mode is active, pass through any button press events
         if (type == pwswd::EventType::Buttons) {
@@ -141,7 +261,7 @@ void calculateMouseMovement() {
             else if (button == pwswd::Button::R3)
                 eventData.code = static_cast<std::uint16_t>(pwswd::Button::MouseRight);
 
-            mouse.inject(eventData);
+            mouse.queue(eventData);
             continue;
 
         // Discard any other events except the relative axis one
@@ -156,39 +276,34 @@ void calculateMouseMovement() {
         if (mouseModeState == pwswd::MouseMode::LeftJoyStick && (axis == pwswd::RelativeAxis::AxisRX || axis == pwswd::RelativeAxis::AxisRY))
             continue;
         if (mouseModeState == pwswd::MouseMode::RightJoyStick && (axis == pwswd::RelativeAxis::AxisX || axis == pwswd::RelativeAxis::AxisY))
-            continue;        
+            continue;
 
-        // Determine the mouse movement direction and speed based on the right joystick's deplacement 
+        // Determine the mouse movement direction and speed based on the joystick's displacement past its calibrated dead zone
+        const auto displacement = stickCalibrator.getDisplacement(eventData.code, value);
         switch (axis) {
             case pwswd::RelativeAxis::AxisX:
-                joystickDisplacementX = pwswd::JoyStickXAxisCenter - value;
+                joystickDisplacementX = -displacement;
                 break;
             case pwswd::RelativeAxis::AxisRX:
-                joystickDisplacementX = value - pwswd::JoyStickXAxisCenter;
+                joystickDisplacementX = displacement;
                 break;
             case pwswd::RelativeAxis::AxisY:
-                joystickDisplacementY = pwswd::JoyStickYAxisCenter - value;
+                joystickDisplacementY = -displacement;
                 break;
             case pwswd::RelativeAxis::AxisRY:
-                joystickDisplacementY = value - pwswd::JoyStickYAxisCenter;
+                joystickDisplacementY = displacement;
                 break;
         }
-
-        //  When joystick is outside the deadzone, linearly determine the cursor speed from it
-        if (std::abs(joystickDisplacementX) > pwswd::JoyStickDeadZone)
-            mouseVelocityX = (joystickDisplacementX > 0 ? 1 : -1) * ((std::abs(joystickDisplacementX) - pwswd::JoyStickDeadZone) / pwswd::JoyStickSpeedDownscaler);
-        else 
-            mouseVelocityX = 0;
-
-        if (std::abs(joystickDisplacementY) > pwswd::JoyStickDeadZone)
-            mouseVelocityY = (joystickDisplacementY > 0 ? 1 : -1) * ((std::abs(joystickDisplacementY) - pwswd::JoyStickDeadZone) / pwswd::JoyStickSpeedDownscaler);
-        else 
-            mouseVelocityY = 0;
-        
     }
+
+    // Forward all passed through buttons of this frame at once
+    mouse.flush();
+
+    // Once all axes of the frame were applied, update the cursor speed. The engine only ticks while the stick is outside the dead zone
+    pointerEngine.setDisplacement(joystickDisplacementX, joystickDisplacementY);
 }
 
-void moveMouse() {
+void initializeMouse() {
     // Initialize mouse uinput device
     mouse.setEventFilterBit(pwswd::EventType::Buttons);
     mouse.setKeyFilterBit(pwswd::Button::MouseLeft);
@@ -214,108 +329,409 @@ void moveMouse() {
     mouse.setRelativeFilterBit(pwswd::RelativeAxis::AxisX);
     mouse.setRelativeFilterBit(pwswd::RelativeAxis::AxisY);
     mouse.createDevice();
+}
 
-    while (true) {
-        mouse.inject(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisX, mouseVelocityX));
-        mouse.inject(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisY, mouseVelocityY));
-        mouse.inject(pwswd::createSyncEvent());
+void moveMouse() {
+    eventLoop.countEvents(pointerTimer.acknowledge());
 
-        usleep(10000);
-    }
+    auto [deltaX, deltaY] = pointerEngine.tick();
+
+    mouse.queue(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisX, deltaX));
+    mouse.queue(pwswd::createRelativeAxisInputEvent(pwswd::RelativeAxis::AxisY, deltaY));
+    mouse.flush();
 }
 
-int main() {
-    bool activatedShortcut = false;
-    bool powerButtonDown = false;
-    timeval timeSincePowerButtonPress = { 0 };
+void handleJoystickEvent() {
+    eventLoop.countEvents(joystickEvent.readFrames([](const pwswd::InputFrame &frame) {
+        if (traceWriter != nullptr)
+            traceWriter->writeFrame(pwswd::TraceSource::Joystick, frame);
 
-    // Initialize services and devices
-    overlayManager.initialize(std::addressof(framebuffer));
-    power.initialize(std::addressof(buttonEvent), std::addressof(screen));
+        calculateMouseMovement(frame);
+    }));
 
-    // Prevent Hangup signals from terminating us
-    signal(SIGHUP, [](int){});
+    if (traceWriter != nullptr)
+        traceWriter->flush();
+}
 
-    // Start overlay drawing thread
-    std::thread overlayThread(drawOverlay);
-    std::thread joystickToMouseCalculatorThread(calculateMouseMovement);
-    std::thread mouseMoveThread(moveMouse);
+void handleButtonInput(const pwswd::InputEvent &eventData) {
+    static bool activatedShortcut = false;
+    static bool powerButtonDown = false;
+    static timeval timeSincePowerButtonPress = { 0 };
 
-    while (true) {
-        // Wait for any button to be pressed
-        buttonEvent.wait();
+    const auto &config = configManager.get();
 
-        auto eventData = buttonEvent.get<pwswd::InputEvent>();
+    const auto &type   = static_cast<pwswd::EventType>(eventData.type);
+    const auto &button = static_cast<pwswd::Button>(eventData.code);
+    const auto &state  = static_cast<pwswd::ButtonState>(eventData.value);
 
-        const auto &type   = static_cast<pwswd::EventType>(eventData.type);
-        const auto &button = static_cast<pwswd::Button>(eventData.code);
-        const auto &state  = static_cast<pwswd::ButtonState>(eventData.value);
+    // Discard any synchronization events
+    if (type == pwswd::EventType::Synchronization)
+        return;
 
-        // Discard any synchronization events
-        if (type == pwswd::EventType::Synchronization)
-            continue;
+    // Handle power button press
+    if (button == pwswd::Button::Power) {
+        std::uint64_t timeSincePowerButtonDown = pwswd::toMicroSeconds(eventData.time) - pwswd::toMicroSeconds(timeSincePowerButtonPress);
 
-        // Handle power button press
-        if (button == pwswd::Button::Power) {
-            std::uint64_t timeSincePowerButtonDown = pwswd::toMicroSeconds(eventData.time) - pwswd::toMicroSeconds(timeSincePowerButtonPress);
-
-            switch (state) {
-                case pwswd::ButtonState::Pressed:
-                    timeSincePowerButtonPress = eventData.time;
-                    powerButtonDown = true;
-                    buttonEvent.grab();     // Prevent applications from getting any button inputs
-                    break;
-                case pwswd::ButtonState::Released:  
-                    
-                    // Unblock button inputs for other apps
-                    buttonEvent.ungrab();
-
-                    // Don't enter sleep mode if the user pressed any button after holding down the power button
-                    if (!activatedShortcut) {
-                        if (timeSincePowerButtonDown < pwswd::PowerButtonShortPressDuration) {
-                            // Lock drawing to the framebuffer
-                            std::scoped_lock lock(framebuffer);
-                            // Close the framebuffer device to prevent pwswd++ from being paused
-                            framebuffer.close();
-
-                            // Toggle sleep mode
-                            power.toggleSleepMode();
-
-                            // Reopen the framebuffer device after pausing is done
-                            framebuffer.open();
-                        }
+        switch (state) {
+            case pwswd::ButtonState::Pressed:
+                timeSincePowerButtonPress = eventData.time;
+                powerButtonDown = true;
+                buttonEvent.grab();     // Prevent applications from getting any button inputs
+                break;
+            case pwswd::ButtonState::Released:  
+                
+                // Unblock button inputs for other apps
+                buttonEvent.ungrab();
+
+                // Don't enter sleep mode if the user pressed any button after holding down the power button
+                if (!activatedShortcut) {
+                    if (timeSincePowerButtonDown < config.powerButtonShortPressDuration) {
+                        // Lock drawing to the framebuffer
+                        std::scoped_lock lock(framebuffer);
+                        // Stop waiting for vblanks before the screen goes off, the vsync worker shares the framebuffer's handle
+                        vsyncClock.suspend();
+                        // Close the framebuffer device to prevent pwswd++ from being paused
+                        framebuffer.close();
+
+                        // Toggle sleep mode
+                        power.toggleSleepMode();
+
+                        // Reopen the framebuffer device after pausing is done
+                        framebuffer.open();
+
+                        // Nothing to move while the screen is off, even if the stick was still deflected
+                        if (power.isScreenOff())
+                            pointerEngine.stop();
+                        else
+                            vsyncClock.resume();
                     }
+                }
 
-                    activatedShortcut = false;
-                    powerButtonDown = false;
+                activatedShortcut = false;
+                powerButtonDown = false;
 
-                    break;
-                case pwswd::ButtonState::Held:
+                break;
+            case pwswd::ButtonState::Held:
 
-                    // If no button was pressed after the power button was held down for a certain duration, power off the device
-                    if (!activatedShortcut)
-                        if (timeSincePowerButtonDown > pwswd::PowerButtonLongPressDuration)
-                            power.powerOff();
-                    break;
+                // If no button was pressed after the power button was held down for a certain duration, power off the device
+                if (!activatedShortcut)
+                    if (timeSincePowerButtonDown > config.powerButtonLongPressDuration)
+                        power.powerOff();
+                break;
+        }
+    
+    // Handle all other button presses
+    } else {
+        if (state == pwswd::ButtonState::Pressed) {
+            // Don't handle shortcuts if the screen is off
+            if (power.isScreenOff())
+                return;
+            
+            // Look up the shortcut in the layer for the power button's current state
+            const auto layer = powerButtonDown ? pwswd::ShortcutLayer::Power : pwswd::ShortcutLayer::Plain;
+            const auto action = config.shortcuts.lookup(layer, eventData.code);
+
+            if (action != pwswd::Action::None) {
+                runAction(action);
+
+                auto &latencies = powerButtonDown ? powerShortcutLatencies : shortcutLatencies;
+                if (eventData.code < latencies.size() && pendingLatencyCount < pendingLatencies.size())
+                    pendingLatencies[pendingLatencyCount++] = { &latencies[eventData.code], pwswd::toMicroSeconds(eventData.time) };
             }
-        
-        // Handle all other button presses
+
+            // Any button pressed while holding power means the power button isn't used to go to sleep
+            if (powerButtonDown)
+                activatedShortcut = true;
+        }
+    }
+}
+
+void handleButtonFrame(const pwswd::InputFrame &frame) {
+    for (const auto &eventData : frame)
+        handleButtonInput(eventData);
+}
+
+// Call once all button frames of a wakeup were handled
+void finishButtonWakeup() {
+    // Key repeats that piled up since the last wakeup only cause a single write per setting
+    screen.flush();
+
+    // Staged settings were written just now, so that's when the actions of this wakeup are done
+    const auto now = buttonEvent.getCurrentTime();
+    for (std::size_t i = 0; i < pendingLatencyCount; i++) {
+        const auto &[histogram, eventTime] = pendingLatencies[i];
+        histogram->record(now > eventTime ? now - eventTime : 0);
+    }
+
+    pendingLatencyCount = 0;
+}
+
+void handleButtonEvent() {
+    eventLoop.countEvents(buttonEvent.readFrames([](const pwswd::InputFrame &frame) {
+        if (traceWriter != nullptr)
+            traceWriter->writeFrame(pwswd::TraceSource::Buttons, frame);
+
+        handleButtonFrame(frame);
+    }));
+
+    finishButtonWakeup();
+
+    if (traceWriter != nullptr)
+        traceWriter->flush();
+}
+
+/**
+ * Deliver SIGUSR1 through the event loop instead of interrupting it. Has to be blocked before any thread
+ * gets started, threads inherit the mask and the kernel may pick any thread that doesn't block a signal
+ * sent to the process. Its default action would kill the daemon then.
+ */
+sigset_t blockStatisticsSignal() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    return signals;
+}
+
+int signalFd(const sigset_t &signals) {
+    return signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+}
+
+// Settings that live in the devices and services themselves instead of being read from the config on every use
+void applyConfig() {
+    const auto &config = configManager.get();
+
+    screen.setBrightnessValues(config.brightnessValues);
+    stickCalibrator.setMaxDeadZone(config.joystickDeadZone);
+}
+
+void watchConfig() {
+    eventLoop.countEvents(configManager.handleFileEvents());
+}
+
+// The worker swapped in a new config, nothing can be using the old one between callbacks
+void reloadConfig() {
+    if (configManager.reclaim())
+        applyConfig();
+}
+
+void printStatistics() {
+    // One "name value" pair per line, names are kept stable so dumps of different releases can be compared
+    std::cout << "statistics_version " << StatisticsVersion << std::endl;
+
+    // Dump wake up statistics to verify the daemon stays asleep while idle
+    std::cout << "wakeups " << eventLoop.getWakeupCount() << std::endl;
+    std::cout << "loop_cpu_time_us " << pwswd::getThreadCpuTime() << std::endl;
+
+    // Times are the wall clock and CPU time spent in the source's callbacks
+    for (const auto &[name, sourceStatistics] : eventLoop.getStatistics()) {
+        std::cout << "loop_" << name << "_wakeups " << sourceStatistics.wakeups << std::endl;
+        std::cout << "loop_" << name << "_events " << sourceStatistics.events << std::endl;
+        std::cout << "loop_" << name << "_time_us " << sourceStatistics.time << std::endl;
+        std::cout << "loop_" << name << "_cpu_time_us " << sourceStatistics.cpuTime << std::endl;
+    }
+
+    const auto &frameStatistics = vsyncClock.getStatistics();
+    std::cout << "overlay_frames " << frameStatistics.frames << std::endl;
+    std::cout << "overlay_missed_deadlines " << frameStatistics.missedDeadlines << std::endl;
+    std::cout << "overlay_render_time_us_max " << frameStatistics.maxRenderTime << std::endl;
+    std::cout << "overlay_render_time_us_total " << frameStatistics.totalRenderTime << std::endl;
+    std::cout << "overlay_blanking_budget_us " << frameStatistics.blankingBudget << std::endl;
+    std::cout << "overlay_hardware_vsync " << frameStatistics.hardwareVSync << std::endl;
+
+    const auto &pointerStatistics = pointerEngine.getStatistics();
+    std::cout << "pointer_ticks " << pointerStatistics.ticks << std::endl;
+    std::cout << "pointer_active_time_us " << pointerStatistics.activeTime << std::endl;
+    std::cout << "pointer_ticks_per_s " << (pointerStatistics.activeTime > 0 ? pointerStatistics.ticks * 1'000'000 / pointerStatistics.activeTime : 0) << std::endl;
+    std::cout << "pointer_jitter_us_mean " << (pointerStatistics.ticks > 0 ? pointerStatistics.totalJitter / pointerStatistics.ticks : 0) << std::endl;
+    std::cout << "pointer_jitter_us_max " << pointerStatistics.maxJitter << std::endl;
+
+    for (auto axis : { pwswd::RelativeAxis::AxisX, pwswd::RelativeAxis::AxisY, pwswd::RelativeAxis::AxisRX, pwswd::RelativeAxis::AxisRY }) {
+        const auto code = static_cast<std::uint16_t>(axis);
+        std::cout << "stick_axis" << code << "_center " << stickCalibrator.getCenter(code) << std::endl;
+        std::cout << "stick_axis" << code << "_dead_zone " << stickCalibrator.getCalibration(code).deadZone << std::endl;
+    }
+
+    // Shortcut latencies per button code, percentiles are rounded up to the histogram's bucket bounds
+    auto printLatencies = [](const char *prefix, const std::array<pwswd::LatencyHistogram, LatencyKeyCount> &latencies) {
+        for (std::uint16_t code = 0; code < latencies.size(); code++) {
+            const auto &histogram = latencies[code];
+            if (histogram.getCount() == 0)
+                continue;
+
+            std::cout << prefix << code << "_count " << histogram.getCount() << std::endl;
+            std::cout << prefix << code << "_p50_us " << histogram.getPercentile(50) << std::endl;
+            std::cout << prefix << code << "_p99_us " << histogram.getPercentile(99) << std::endl;
+            std::cout << prefix << code << "_max_us " << histogram.getMax() << std::endl;
+        }
+    };
+
+    printLatencies("latency_power_button", powerShortcutLatencies);
+    printLatencies("latency_button", shortcutLatencies);
+
+    std::cout << "config_reloads " << configManager.getReloadCount() << std::endl;
+
+    const auto screenshotStatistics = screenshotManager.getStatistics();
+    std::cout << "screenshots " << screenshotStatistics.screenshots << std::endl;
+    std::cout << "screenshot_failures " << screenshotStatistics.failures << std::endl;
+    std::cout << "screenshot_capture_time_us_last " << screenshotStatistics.lastCaptureTime << std::endl;
+    std::cout << "screenshot_capture_time_us_max " << screenshotStatistics.maxCaptureTime << std::endl;
+    std::cout << "screenshot_encode_time_us_last " << screenshotStatistics.lastEncodeTime << std::endl;
+    std::cout << "screenshot_encode_pixels_per_s_last " << screenshotStatistics.lastEncodeThroughput << std::endl;
+    std::cout << "screenshot_file_size_last " << screenshotStatistics.lastFileSize << std::endl;
+    std::cout << "screenshot_worker_cpu_time_us " << screenshotStatistics.workerCpuTime << std::endl;
+}
+
+void handleSignal(int signalfd) {
+    signalfd_siginfo info;
+    read(signalfd, &info, sizeof(info));
+
+    printStatistics();
+}
+
+void finishReplay() {
+    const auto time = std::max<std::uint64_t>(pwswd::getMonotonicTime() - replay.startTime, 1);
+
+    // Only what the replay caused, not what happened while starting up
+    std::cout << "replay_frames " << replay.frames << std::endl;
+    std::cout << "replay_events " << replay.events << std::endl;
+    std::cout << "replay_time_us " << time << std::endl;
+    std::cout << "replay_frames_per_s " << replay.frames * 1'000'000 / time << std::endl;
+    std::cout << "replay_uinput_frames " << mouse.getFrameCount() - replay.uinputFrames << std::endl;
+    std::cout << "replay_uinput_events " << mouse.getEventCount() - replay.uinputEvents << std::endl;
+    std::cout << "replay_sysfs_writes " << screen.getWriteCount() - replay.sysfsWrites << std::endl;
+    std::cout << "replay_overlays " << overlayManager.getEnqueueCount() - replay.overlays << std::endl;
+
+    printStatistics();
+
+    std::exit(0);
+}
+
+void replayFrames() {
+    replayTimer.acknowledge();
+
+    const auto now = pwswd::getMonotonicTime();
+
+    // In real time everything that's due gets dispatched, otherwise one frame per wakeup so the timers still get their turn
+    while (replay.nextFrame.has_value()) {
+        auto &frame = *replay.nextFrame;
+        if (replay.realTime && replay.startTime + frame.time > now)
+            break;
+
+        // Move the trace's timestamps onto the input devices' clock, durations like holding the power button stay the same
+        for (auto &event : frame.events) {
+            const auto time = replay.clockBase + pwswd::toMicroSeconds(event.time);
+            event.time = { time_t(time / 1'000'000), suseconds_t(time % 1'000'000) };
+        }
+
+        const pwswd::InputFrame inputFrame = { frame.events.data(), frame.events.size() };
+        if (frame.source == pwswd::TraceSource::Buttons) {
+            handleButtonFrame(inputFrame);
+            finishButtonWakeup();
         } else {
-            if (state == pwswd::ButtonState::Pressed) {
-                // Don't handle shortcuts if the screen is off
-                if (power.isScreenOff())
-                    continue;
-                
-                // Handle shortcuts with the power button held down
-                if (powerButtonDown) {
-                    handlePowerShortcut(static_cast<pwswd::Button>(eventData.code));
-                    activatedShortcut = true;
-
-                // Handle shortcuts without the power button held down
-                } else {
-                    handleShortcuts(static_cast<pwswd::Button>(eventData.code));
-                }
-            }
+            calculateMouseMovement(inputFrame);
         }
+
+        eventLoop.countEvents(frame.events.size());
+        replay.frames++;
+        replay.events += frame.events.size();
+
+        replay.nextFrame = replay.reader->readFrame();
+
+        if (!replay.realTime)
+            break;
     }
+
+    if (!replay.nextFrame.has_value())
+        finishReplay();
+
+    replayTimer.armAt(replay.realTime ? replay.startTime + replay.nextFrame->time : pwswd::getMonotonicTime());
+}
+
+void startReplay(const std::string &path, bool realTime) {
+    replay.reader = std::make_unique<pwswd::TraceReader>(path);
+    replay.nextFrame = replay.reader->readFrame();
+    replay.realTime = realTime;
+
+    // Shortcuts that power off, suspend or kill applications only update the state they'd leave behind
+    power.setDryRun(true);
+
+    replay.startTime = pwswd::getMonotonicTime();
+    replay.clockBase = buttonEvent.getCurrentTime();
+    replay.uinputFrames = mouse.getFrameCount();
+    replay.uinputEvents = mouse.getEventCount();
+    replay.sysfsWrites = screen.getWriteCount();
+    replay.overlays = overlayManager.getEnqueueCount();
+
+    if (!replay.nextFrame.has_value())
+        finishReplay();
+
+    replayTimer.armAt(replay.startTime);
+}
+
+int main(int argc, char **argv) {
+    const sigset_t statisticsSignals = blockStatisticsSignal();
+
+    std::optional<std::string> recordPath, replayPath;
+    bool realTime = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+
+        if (argument == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (argument == "--replay" && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (argument == "--realtime")
+            realTime = true;
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--record <trace> | --replay <trace> [--realtime]]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Initialize services and devices, SIGUSR1 has to be blocked by now since some of them start threads
+    configManager.initialize(paths.configFile);
+    overlayManager.initialize(std::addressof(framebuffer), std::addressof(overlayNotifier));
+    vsyncClock.initialize(std::addressof(framebuffer), std::addressof(overlayTimer), OverlayFrameRate);
+    pointerEngine.initialize(std::addressof(pointerTimer));
+    stickCalibrator.initialize(std::addressof(joystickEvent));
+    screenshotManager.initialize(std::addressof(framebuffer), std::addressof(overlayManager), paths.screenshotDirectory, ScreenshotFormat);
+    screen.initialize(std::addressof(holderResolver));
+    power.initialize(std::addressof(buttonEvent), std::addressof(screen), std::addressof(holderResolver));
+
+    applyConfig();
+
+    initializeMouse();
+
+    // map the framebuffer into the address space
+    framebuffer.map();
+
+    // Prevent Hangup signals from terminating us
+    signal(SIGHUP, [](int){});
+
+    int statisticsSignalFd = signalFd(statisticsSignals);
+
+    if (recordPath.has_value())
+        traceWriter = std::make_unique<pwswd::TraceWriter>(*recordPath);
+
+    // Multiplex all inputs, timers and wake ups through a single event loop. A replay replaces the input devices
+    if (replayPath.has_value()) {
+        eventLoop.add(replayTimer.getFd(), "replay", replayFrames);
+        startReplay(*replayPath, realTime);
+    } else {
+        eventLoop.add(buttonEvent.getFd(), "buttons", handleButtonEvent);
+        eventLoop.add(joystickEvent.getFd(), "joystick", handleJoystickEvent);
+    }
+
+    eventLoop.add(pointerTimer.getFd(), "pointer", moveMouse);
+    eventLoop.add(overlayTimer.getFd(), "overlay", drawOverlay);
+    eventLoop.add(overlayNotifier.getFd(), "overlay", wakeOverlay);
+    eventLoop.add(configManager.getWatchFd(), "config", watchConfig);
+    eventLoop.add(configManager.getReloadFd(), "config", reloadConfig);
+    eventLoop.add(statisticsSignalFd, "statistics", [statisticsSignalFd]{ handleSignal(statisticsSignalFd); });
+
+    eventLoop.run();
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "test.hpp"
+#include "bounded_queue.hpp"
+
+using pwswd::test::check;
+
+// Several producers push numbered values into a small queue while one consumer drains it. Built with
+// ThreadSanitizer, so races fail the test even if every value happens to come out right
+int main() {
+    constexpr std::uint32_t ProducerCount = 4;
+    constexpr std::uint32_t ValuesPerProducer = 100'000;
+
+    // Small enough that producers constantly run into a full queue
+    pwswd::BoundedQueue<std::uint64_t, 16> queue;
+
+    std::vector<std::thread> producers;
+    for (std::uint32_t producer = 0; producer < ProducerCount; producer++) {
+        producers.emplace_back([&queue, producer] {
+            for (std::uint32_t sequence = 0; sequence < ValuesPerProducer; sequence++) {
+                const std::uint64_t value = (std::uint64_t(producer) << 32) | sequence;
+
+                while (!queue.push(value))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Values of one producer have to arrive in the order they were pushed, so the next expected one tells lost from duplicated values
+    std::vector<std::uint32_t> nextSequence(ProducerCount, 0);
+    std::uint64_t received = 0, unexpected = 0;
+
+    while (received < std::uint64_t(ProducerCount) * ValuesPerProducer) {
+        auto value = queue.pop();
+        if (!value.has_value()) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const std::uint32_t producer = *value >> 32;
+        const std::uint32_t sequence = *value & 0xFFFF'FFFF;
+
+        if (producer >= ProducerCount || sequence != nextSequence[producer])
+            unexpected++;
+        else
+            nextSequence[producer]++;
+
+        received++;
+    }
+
+    for (auto &producer : producers)
+        producer.join();
+
+    check(unexpected == 0, "every value arrives exactly once and in order per producer");
+    for (std::uint32_t producer = 0; producer < ProducerCount; producer++)
+        check(nextSequence[producer] == ValuesPerProducer, "all values of producer " + std::to_string(producer) + " arrived");
+
+    check(queue.empty() && !queue.pop().has_value(), "queue is empty afterwards");
+
+    return pwswd::test::result();
+}
\ No newline at end of file
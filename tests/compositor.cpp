@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "compositor.hpp"
+#include "devices/fake_framebuffer.hpp"
+
+using pwswd::test::check;
+
+constexpr std::uint32_t Width = 64, Height = 48;
+
+// Gives every page its own pattern, so pixels that end up on the wrong page or in the wrong place get noticed
+void fillPages(pwswd::dev::Framebuffer &framebuffer) {
+    const std::size_t pageSize = framebuffer.getSize();
+
+    for (std::size_t offset = 0; offset < pageSize * pwswd::dev::Framebuffer::NumFramebuffers; offset++)
+        framebuffer.getAddress()[offset] = (offset * 7 + offset / pageSize * 64) & 0xFF;
+}
+
+[[nodiscard]] std::vector<std::uint8_t> copyPage(pwswd::dev::Framebuffer &framebuffer, std::uint8_t page) {
+    const auto begin = framebuffer.getAddress() + page * framebuffer.getSize();
+
+    return { begin, begin + framebuffer.getSize() };
+}
+
+// Draws a frame of the overlay the way OverlayManager does
+void drawFrame(pwswd::Compositor &compositor, pwswd::dev::Framebuffer &framebuffer, const pwswd::dev::Rect &rect, std::uint32_t color) {
+    compositor.prepare({ rect });
+    framebuffer.fillRect(rect, color);
+    compositor.commit(rect);
+}
+
+[[nodiscard]] bool isFilled(pwswd::dev::Framebuffer &framebuffer, const pwswd::dev::Rect &rect, std::uint32_t color) {
+    const auto encoded = framebuffer.encodeColor(color >> 24, color >> 16, color >> 8, color);
+    const auto surface = framebuffer.getVisibleSurface().getSubSurface(rect.x, rect.y, rect.w, rect.h);
+
+    for (std::uint32_t y = 0; y < surface.height; y++)
+        for (std::uint32_t x = 0; x < surface.width; x++)
+            if (std::memcmp(surface.getPixelAddress(x, y), &encoded, surface.bytesPerPixel) != 0)
+                return false;
+
+    return true;
+}
+
+int main() {
+    for (std::uint32_t bitsPerPixel : { 16, 32 }) {
+        pwswd::dev::FakeFramebuffer fakeFramebuffer(Width, Height, bitsPerPixel);
+        auto &framebuffer = fakeFramebuffer.get();
+        const std::string format = std::to_string(bitsPerPixel) + "bpp: ";
+
+        const pwswd::dev::Rect rect = { 8, 30, 40, 10 }, movedRect = { 4, 2, 20, 12 };
+
+        // The exact bytes underneath come back once the overlay times out
+        {
+            fillPages(framebuffer);
+            const auto original = copyPage(framebuffer, 0);
+
+            pwswd::Compositor compositor;
+            compositor.initialize(std::addressof(framebuffer));
+
+            drawFrame(compositor, framebuffer, rect, 0x102030FF);
+            check(isFilled(framebuffer, rect, 0x102030FF), format + "overlay is drawn");
+
+            drawFrame(compositor, framebuffer, rect, 0x405060FF);
+            check(isFilled(framebuffer, rect, 0x405060FF), format + "overlay is redrawn in place");
+
+            compositor.restore();
+            check(copyPage(framebuffer, 0) == original, format + "restore puts back the bytes underneath the overlay");
+            check(!compositor.isDirty(), format + "nothing is left to restore");
+        }
+
+        // Moving the overlay restores the rect it left and backs up the one it moved to
+        {
+            fillPages(framebuffer);
+            const auto original = copyPage(framebuffer, 0);
+
+            pwswd::Compositor compositor;
+            compositor.initialize(std::addressof(framebuffer));
+
+            drawFrame(compositor, framebuffer, rect, 0x102030FF);
+
+            compositor.prepare({ movedRect });
+            auto moved = copyPage(framebuffer, 0);
+            check(moved == original, format + "the old rect is restored before the moved one gets drawn");
+
+            framebuffer.fillRect(movedRect, 0x102030FF);
+            compositor.commit(movedRect);
+
+            compositor.restore();
+            check(copyPage(framebuffer, 0) == original, format + "restore after moving puts back the bytes underneath the moved rect");
+        }
+
+        // After a flip the page the overlay was drawn on belongs to the game, its backup is dropped instead of written back
+        {
+            fillPages(framebuffer);
+            fakeFramebuffer.flip(0);
+
+            pwswd::Compositor compositor;
+            compositor.initialize(std::addressof(framebuffer));
+
+            drawFrame(compositor, framebuffer, rect, 0x102030FF);
+            const auto drawnPage = copyPage(framebuffer, 0);
+            const auto visiblePage = copyPage(framebuffer, 1);
+
+            fakeFramebuffer.flip(1);
+            drawFrame(compositor, framebuffer, rect, 0x405060FF);
+
+            check(copyPage(framebuffer, 0) == drawnPage, format + "the backup isn't written back to the page that's not visible anymore");
+            check(isFilled(framebuffer, rect, 0x405060FF), format + "the overlay is drawn on the visible page");
+
+            compositor.restore();
+            check(copyPage(framebuffer, 1) == visiblePage, format + "restore puts back the visible page's bytes");
+            check(copyPage(framebuffer, 0) == drawnPage, format + "restore leaves the old page alone");
+        }
+    }
+
+    return pwswd::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "compositor.hpp"
+#include "devices/fake_framebuffer.hpp"
+
+using pwswd::test::check;
+
+// Checks every pixel of the visible page through the raw mapping, so a stale pitch shows up as sheared or missing rows
+[[nodiscard]] bool isPageFilled(pwswd::dev::Framebuffer &framebuffer, std::uint32_t color) {
+    const auto encoded = framebuffer.encodeColor(color >> 24, color >> 16, color >> 8, color);
+    const auto [xres, yres] = framebuffer.getResolution();
+    const auto page = framebuffer.getAddress() + framebuffer.getVisiblePageOffset();
+
+    for (std::uint32_t y = 0; y < yres; y++)
+        for (std::uint32_t x = 0; x < xres; x++)
+            if (std::memcmp(&page[y * framebuffer.getPitch() + x * framebuffer.getStride()], &encoded, framebuffer.getStride()) != 0)
+                return false;
+
+    return true;
+}
+
+int main() {
+    pwswd::dev::FakeFramebuffer fakeFramebuffer(64, 48, 16);
+    auto &framebuffer = fakeFramebuffer.get();
+
+    pwswd::Compositor compositor;
+    compositor.initialize(std::addressof(framebuffer));
+
+    const pwswd::dev::Rect rect = { 8, 30, 40, 10 };
+    compositor.prepare({ rect });
+    framebuffer.fillRect(rect, 0x102030FF);
+    compositor.commit(rect);
+
+    // Page flips don't change the layout
+    const auto layoutVersion = framebuffer.getLayoutVersion();
+    fakeFramebuffer.flip(1);
+    fakeFramebuffer.flip(0);
+    check(framebuffer.getLayoutVersion() == layoutVersion, "page flips keep the layout version");
+
+    // A bigger mode with a wider pitch than the first mapping covers
+    fakeFramebuffer.setMode(128, 96, 32);
+    check(framebuffer.getLayoutVersion() != layoutVersion, "a mode change bumps the layout version");
+    check(framebuffer.getPitch() == 128 * 4, "the pitch follows the mode change");
+    check(framebuffer.getSize() == 128 * 4 * 96, "the page size follows the mode change");
+
+    // Backups of the old mode must not be written into the new layout
+    const auto *address = framebuffer.getAddress();
+    const std::vector<std::uint8_t> before(address, address + framebuffer.getSize());
+    compositor.prepare({});
+    check(std::memcmp(framebuffer.getAddress(), before.data(), before.size()) == 0, "backups of the old mode are dropped");
+
+    for (std::uint8_t page = 0; page < pwswd::dev::Framebuffer::NumFramebuffers; page++) {
+        fakeFramebuffer.flip(page);
+        check(framebuffer.isVisiblePageMapped(), "page " + std::to_string(page) + " of the bigger mode is mapped");
+
+        const auto [xres, yres] = framebuffer.getResolution();
+        framebuffer.fillRect({ 0, 0, xres, yres }, 0x405060FF);
+        check(isPageFilled(framebuffer, 0x405060FF), "page " + std::to_string(page) + " of the bigger mode is drawn without shearing");
+    }
+
+    // Going back to a smaller mode keeps the bigger mapping
+    fakeFramebuffer.setMode(64, 48, 16);
+    fakeFramebuffer.flip(2);
+    check(framebuffer.getPitch() == 64 * 2, "the pitch follows a smaller mode");
+    check(framebuffer.isVisiblePageMapped(), "the last page of the smaller mode is mapped");
+
+    framebuffer.fillRect({ 0, 0, 64, 48 }, 0x708090FF);
+    check(isPageFilled(framebuffer, 0x708090FF), "the smaller mode is drawn without shearing");
+
+    return pwswd::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "test.hpp"
+#include "devices/fake_proc.hpp"
+#include "devices/fake_sysfs.hpp"
+#include "devices/holder_resolver.hpp"
+
+using pwswd::test::check;
+
+// Pids fuser reports for the path, empty if it isn't installed
+std::vector<pid_t> runFuser(const std::string &path) {
+    std::vector<pid_t> pids;
+
+    std::FILE *output = popen(("fuser " + path + " 2>/dev/null").c_str(), "r");
+    if (output == nullptr)
+        return pids;
+
+    int pid;
+    while (std::fscanf(output, "%d", &pid) == 1)
+        pids.push_back(pid);
+
+    pclose(output);
+    std::sort(pids.begin(), pids.end());
+
+    return pids;
+}
+
+int main() {
+    // Plain files are stand-ins for the framebuffer, a second name for the same inode comes from a hard link
+    pwswd::dev::FakeSysfs files;
+    files.addAttribute("/fb0", "");
+    files.addAttribute("/tty1", "");
+    const auto framebufferPath = files.getRoot() + "/fb0";
+    const auto consolePath = files.getRoot() + "/tty1";
+    const auto framebufferLink = files.getRoot() + "/fb0-link";
+    check(::link(framebufferPath.c_str(), framebufferLink.c_str()) == 0, "hard link to the fake framebuffer");
+
+    // Device nodes match by device number, no matter which path leads to them
+    const auto nullLink = files.getRoot() + "/null-link";
+    check(::symlink("/dev/null", nullLink.c_str()) == 0, "symlink to /dev/null");
+
+    {
+        pwswd::dev::FakeProc proc;
+        proc.addFile(100, 3, framebufferPath);
+        proc.addFile(101, 4, framebufferLink);
+        proc.addFile(102, 5, consolePath);
+        proc.addFile(103, 0, "/dev/null");
+        proc.addFile(104, 6, "pipe:[1234]");
+        proc.addFile(104, 7, "socket:[5678]");
+        proc.addFile("self", 3, framebufferPath);
+        proc.addFile(getpid(), 3, framebufferPath);
+
+        pwswd::dev::HolderResolver resolver(proc.getRoot());
+
+        auto framebufferHolders = resolver.findHolders(framebufferPath);
+        std::sort(framebufferHolders.begin(), framebufferHolders.end());
+        check(framebufferHolders == std::vector<pid_t>({ 100, 101 }), "framebuffer holders match by inode, hard links included, without self");
+        check(resolver.findHolders(consolePath) == std::vector<pid_t>({ 102 }), "console holder");
+        check(resolver.findHolders(nullLink) == std::vector<pid_t>({ 103 }), "device nodes match by device number");
+
+        const auto both = resolver.findHoldersOfEach({ consolePath, files.getRoot() + "/missing" });
+        check(both.size() == 2 && both[0] == std::vector<pid_t>({ 102 }) && both[1].empty(), "one scan for several paths, missing paths have no holders");
+
+        check(resolver.findCachedHolders(consolePath) == std::vector<pid_t>({ 102 }), "cached holders are re-checked");
+    }
+
+    // A file nothing in the fake proc holds doesn't match anything
+    {
+        pwswd::dev::FakeProc proc;
+        proc.addFile(200, 3, consolePath);
+
+        pwswd::dev::HolderResolver resolver(proc.getRoot());
+        check(resolver.findHolders(framebufferPath).empty(), "no holders");
+    }
+
+    // Against the real /proc the results have to be the same as fuser's
+    {
+        int ready[2], release[2];
+        check(pipe(ready) == 0 && pipe(release) == 0, "pipes to the holding child");
+
+        pid_t child = fork();
+        if (child == 0) {
+            int fd = open(framebufferPath.c_str(), O_RDONLY);
+            char byte = 0;
+            write(ready[1], &byte, 1);
+            read(release[0], &byte, 1);
+            close(fd);
+            _exit(0);
+        }
+
+        char byte;
+        read(ready[0], &byte, 1);
+
+        pwswd::dev::HolderResolver resolver;
+        auto holders = resolver.findHolders(framebufferPath);
+        std::sort(holders.begin(), holders.end());
+
+        check(holders == std::vector<pid_t>({ child }), "the child is the only holder in /proc");
+
+        const auto fuserHolders = runFuser(framebufferPath);
+        if (fuserHolders.empty())
+            std::cerr << "fuser not available, skipping the comparison" << std::endl;
+        else
+            check(holders == fuserHolders, "same holders as fuser");
+
+        write(release[1], &byte, 1);
+        waitpid(child, nullptr, 0);
+    }
+
+    ::unlink(framebufferLink.c_str());
+    ::unlink(nullLink.c_str());
+
+    return pwswd::test::result();
+}
\ No newline at end of file
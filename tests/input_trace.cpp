@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test.hpp"
+#include "events.hpp"
+#include "input_trace.hpp"
+
+using pwswd::test::check;
+
+pwswd::InputEvent createEvent(pwswd::Button button, std::uint64_t time) {
+    auto event = pwswd::createButtonInputEvent(button, pwswd::ButtonState::Pressed);
+    event.time = { time_t(time / 1'000'000), suseconds_t(time % 1'000'000) };
+
+    return event;
+}
+
+// Writes frames of both sources with interleaved timestamps and checks they come back with their original timing
+int main() {
+    char path[] = "/tmp/pwswdpp-trace-XXXXXX";
+    int fd = mkstemp(path);
+    check(fd != -1, "temporary trace file");
+    close(fd);
+
+    // The joystick frame was read after the button frame but is older, like when both devices had frames pending
+    const std::vector<std::pair<pwswd::TraceSource, std::uint64_t>> frames = {
+        { pwswd::TraceSource::Buttons,  10'000'000 },
+        { pwswd::TraceSource::Buttons,  10'500'000 },
+        { pwswd::TraceSource::Joystick, 10'200'000 },
+        { pwswd::TraceSource::Buttons,  12'500'000 },
+        { pwswd::TraceSource::Joystick, 13'000'000 },
+    };
+
+    {
+        pwswd::TraceWriter writer(path);
+
+        for (const auto &[source, time] : frames) {
+            const auto event = createEvent(pwswd::Button::A, time);
+            writer.writeFrame(source, { &event, 1 });
+        }
+    }
+
+    pwswd::TraceReader reader(path);
+    std::vector<std::uint64_t> times;
+    while (auto frame = reader.readFrame())
+        times.push_back(frame->time);
+
+    check(times.size() == frames.size(), "every frame is read back");
+    if (times.size() == frames.size()) {
+        check(times[1] == 500'000, "button frames keep their distance");
+        check(times[2] == 500'000, "an older frame is clamped to the one before it");
+        check(times[3] == 2'500'000, "frames after an older one aren't shifted");
+        check(times[4] == 3'000'000, "the last frame keeps its time");
+    }
+
+    std::remove(path);
+
+    return pwswd::test::result();
+}
\ No newline at end of file
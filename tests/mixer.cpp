@@ -0,0 +1,70 @@
+#include <memory>
+#include <string>
+
+#include "test.hpp"
+#include "devices/audio.hpp"
+#include "devices/mixer.hpp"
+
+using pwswd::test::check;
+
+// Drives the volume logic through Audio against an in-memory control element
+int main() {
+    // Percentages map linearly onto the element's range
+    {
+        auto mixer = std::make_unique<pwswd::dev::MockMixer>(0, 255);
+        auto mock = mixer.get();
+        pwswd::dev::Audio audio(std::move(mixer));
+
+        check(audio.getVolume() == 0, "volume starts at the element's minimum");
+
+        audio.increase(10);
+        check(audio.getVolume() == 10, "increase by 10% from 0%");
+        check(mock->getRawValue(0) == 26 && mock->getRawValue(1) == 26, "all channels get the raw value for 10%");
+
+        audio.decrease(5);
+        check(audio.getVolume() == 5, "decrease by 5% from 10%");
+
+        audio.mute();
+        check(audio.getVolume() == 0 && mock->getRawValue(0) == 0, "mute sets the element to its minimum");
+    }
+
+    // Steps past either end of the range get clamped, without writing if nothing changes
+    {
+        auto mixer = std::make_unique<pwswd::dev::MockMixer>(-20, 80);
+        auto mock = mixer.get();
+        pwswd::dev::Audio audio(std::move(mixer));
+
+        for (int i = 0; i < 30; i++)
+            audio.increase(5);
+        check(audio.getVolume() == 100 && mock->getRawValue() == 80, "increase clamps at the element's maximum");
+
+        const auto writes = mock->getWriteCount();
+        audio.increase(5);
+        check(mock->getWriteCount() == writes, "increase at 100% doesn't write");
+
+        for (int i = 0; i < 30; i++)
+            audio.decrease(5);
+        check(audio.getVolume() == 0 && mock->getRawValue() == -20, "decrease clamps at the element's minimum");
+
+        const auto writesAtMinimum = mock->getWriteCount();
+        audio.decrease(5);
+        check(mock->getWriteCount() == writesAtMinimum, "decrease at 0% doesn't write");
+    }
+
+    // Elements coarser than the step still move by one raw step every time
+    {
+        auto mixer = std::make_unique<pwswd::dev::MockMixer>(0, 3);
+        auto mock = mixer.get();
+        pwswd::dev::Audio audio(std::move(mixer));
+
+        for (long expected = 1; expected <= 3; expected++) {
+            audio.increase(5);
+            check(mock->getRawValue() == expected, "5% increase on a 4 step element moves to raw " + std::to_string(expected));
+        }
+
+        audio.decrease(5);
+        check(mock->getRawValue() == 2, "5% decrease on a 4 step element moves down one raw step");
+    }
+
+    return pwswd::test::result();
+}
\ No newline at end of file
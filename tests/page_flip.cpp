@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test.hpp"
+#include "overlay_manager.hpp"
+#include "devices/fake_framebuffer.hpp"
+
+using pwswd::test::check;
+
+[[nodiscard]] std::vector<std::uint8_t> copyPage(pwswd::dev::Framebuffer &framebuffer, std::uint8_t page) {
+    const auto begin = framebuffer.getAddress() + page * framebuffer.getSize();
+
+    return { begin, begin + framebuffer.getSize() };
+}
+
+// Renders an overlay while the game flips pages underneath it, the way the frame timer does
+int main() {
+    constexpr std::uint32_t Timeout = 50;
+
+    for (std::uint32_t bitsPerPixel : { 16, 32 }) {
+        pwswd::dev::FakeFramebuffer fakeFramebuffer(320, 240, bitsPerPixel);
+        auto &framebuffer = fakeFramebuffer.get();
+        const std::string format = std::to_string(bitsPerPixel) + "bpp: ";
+
+        // Every page gets its own pattern, so pixels that end up on the wrong page get noticed
+        const std::size_t pageSize = framebuffer.getSize();
+        for (std::size_t offset = 0; offset < pageSize * pwswd::dev::Framebuffer::NumFramebuffers; offset++)
+            framebuffer.getAddress()[offset] = (offset * 7 + offset / pageSize * 64) & 0xFF;
+
+        const auto firstPage = copyPage(framebuffer, 0), secondPage = copyPage(framebuffer, 1);
+
+        pwswd::OverlayManager overlayManager;
+        overlayManager.initialize(std::addressof(framebuffer), nullptr);
+
+        overlayManager.enqueueOverlay({ pwswd::OverlayType::VolumeSlider, 50, Timeout });
+        overlayManager.render();
+
+        const auto drawnPage = copyPage(framebuffer, 0);
+        check(drawnPage != firstPage, format + "the overlay is drawn on the first page");
+
+        // The game flips, the first page is its back buffer now
+        fakeFramebuffer.flip(1);
+        overlayManager.render();
+
+        check(copyPage(framebuffer, 0) == drawnPage, format + "the stale backup isn't written back to the first page");
+        check(copyPage(framebuffer, 1) != secondPage, format + "the overlay is drawn on the visible page");
+
+        usleep(Timeout * 2'000);
+        overlayManager.render();
+
+        check(copyPage(framebuffer, 1) == secondPage, format + "the visible page is restored once the overlay timed out");
+        check(copyPage(framebuffer, 0) == drawnPage, format + "the first page is left to the game");
+        check(!overlayManager.isActive(), format + "nothing is left to draw or restore");
+    }
+
+    return pwswd::test::result();
+}
\ No newline at end of file
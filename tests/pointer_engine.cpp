@@ -0,0 +1,39 @@
+#include <memory>
+
+#include "test.hpp"
+#include "event_loop.hpp"
+#include "pointer_engine.hpp"
+
+using pwswd::test::check;
+
+// The tick timer should only run while the stick is deflected, an idle stick mustn't cost any wakeups
+int main() {
+    pwswd::Timer pointerTimer;
+    pwswd::PointerEngine pointerEngine;
+    pointerEngine.initialize(std::addressof(pointerTimer));
+
+    check(!pointerTimer.isArmed(), "the timer starts out disarmed");
+
+    pointerEngine.setDisplacement(800, -400);
+    check(pointerTimer.isArmed(), "a deflected stick arms the timer");
+
+    pointerEngine.setDisplacement(0, 0);
+    check(!pointerTimer.isArmed(), "returning to the dead zone disarms the timer");
+
+    // Like the screen turning off while the stick is still deflected
+    pointerEngine.setDisplacement(0, 1200);
+    pointerEngine.stop();
+    check(!pointerTimer.isArmed(), "stop disarms the timer");
+
+    // An expiration that was already pending when the engine stopped neither moves the cursor nor re-arms the timer
+    const auto [deltaX, deltaY] = pointerEngine.tick();
+    check(deltaX == 0 && deltaY == 0, "a tick after stopping doesn't move the cursor");
+    check(!pointerTimer.isArmed(), "a tick after stopping keeps the timer disarmed");
+
+    pointerEngine.setDisplacement(-300, 0);
+    check(pointerTimer.isArmed(), "the next deflection re-arms the timer");
+
+    pointerEngine.stop();
+
+    return pwswd::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test.hpp"
+#include "events.hpp"
+#include "input_trace.hpp"
+#include "stick_calibrator.hpp"
+
+using pwswd::test::check;
+
+constexpr auto Axis = pwswd::RelativeAxis::AxisX;
+constexpr std::int32_t Center = pwswd::JoyStickXAxisCenter;
+constexpr std::uint64_t SampleInterval = 10'000;
+
+// Small deterministic noise, the same trace every run
+class Noise {
+public:
+    explicit Noise(std::int32_t amplitude) : m_amplitude(amplitude) { }
+
+    std::int32_t next() {
+        this->m_state = this->m_state * 1103515245 + 12345;
+        return std::int32_t((this->m_state >> 16) % (2 * this->m_amplitude + 1)) - this->m_amplitude;
+    }
+
+private:
+    std::int32_t m_amplitude;
+    std::uint32_t m_state = 1;
+};
+
+// Records one axis reading per sample into a trace, like --record does for a real stick
+class TraceBuilder {
+public:
+    TraceBuilder() {
+        char path[] = "/tmp/pwswdpp-trace-XXXXXX";
+        int fd = mkstemp(path);
+        if (fd != -1)
+            close(fd);
+
+        this->m_path = path;
+        this->m_writer = std::make_unique<pwswd::TraceWriter>(this->m_path);
+    }
+
+    ~TraceBuilder() {
+        std::remove(this->m_path.c_str());
+    }
+
+    // Value of the axis over time, one sample every SampleInterval
+    void add(std::uint64_t duration, const std::function<std::int32_t(std::uint64_t)> &value) {
+        for (std::uint64_t elapsed = 0; elapsed < duration; elapsed += SampleInterval, this->m_time += SampleInterval) {
+            auto event = pwswd::createAbsoluteAxisInputEvent(Axis, value(elapsed));
+            event.time = { time_t(this->m_time / 1'000'000), suseconds_t(this->m_time % 1'000'000) };
+
+            this->m_writer->writeFrame(pwswd::TraceSource::Joystick, { &event, 1 });
+        }
+    }
+
+    // Time since the start of the trace, the way TraceReader reports it
+    [[nodiscard]] std::uint64_t getTime() const {
+        return this->m_time - StartTime;
+    }
+
+    // Finishes the trace and returns its path
+    [[nodiscard]] const std::string& finish() {
+        this->m_writer.reset();
+        return this->m_path;
+    }
+
+private:
+    static constexpr std::uint64_t StartTime = 1'000'000;
+
+    std::string m_path;
+    std::unique_ptr<pwswd::TraceWriter> m_writer;
+    std::uint64_t m_time = StartTime;
+};
+
+// Feeds every reading of a trace into the calibrator the way the daemon does and hands it to the callback afterwards
+void replay(const std::string &path, pwswd::StickCalibrator &calibrator, const std::function<void(std::uint64_t, std::int32_t)> &callback) {
+    pwswd::TraceReader reader(path);
+
+    while (auto frame = reader.readFrame()) {
+        for (const auto &event : frame->events) {
+            calibrator.update(event.code, event.value, pwswd::toMicroSeconds(event.time));
+            callback(frame->time, event.value);
+        }
+    }
+}
+
+int main() {
+    const auto axis = static_cast<std::uint16_t>(Axis);
+
+    // A resting stick that drifts away from the nominal center by 250 over two minutes. It must never move the cursor,
+    // the center has to follow and the dead zone has to end up much tighter than the default
+    {
+        TraceBuilder trace;
+        Noise noise(12);
+        trace.add(120'000'000, [&](std::uint64_t elapsed) { return Center + 100 + std::int32_t(elapsed / 480'000) + noise.next(); });
+
+        pwswd::StickCalibrator calibrator("/dev/null");
+        std::uint64_t falseMoves = 0;
+        replay(trace.finish(), calibrator, [&](std::uint64_t, std::int32_t value) {
+            falseMoves += calibrator.getDisplacement(axis, value) != 0;
+        });
+
+        check(falseMoves == 0, "a drifting resting stick never moves the cursor, got " + std::to_string(falseMoves) + " moves");
+        check(std::abs(calibrator.getCenter(axis) - (Center + 350)) < 20, "center follows the drift, ended at " + std::to_string(calibrator.getCenter(axis)));
+        check(calibrator.getCalibration(axis).deadZone < pwswd::JoyStickDeadZone / 2, "dead zone shrinks to the noise, ended at " + std::to_string(calibrator.getCalibration(axis).deadZone));
+    }
+
+    // Once calibrated, holding the stick just past the dead zone for slow cursor movement has to keep moving the
+    // cursor for as long as it's held, the center mustn't creep towards the held position
+    {
+        TraceBuilder trace;
+        Noise noise(8);
+        trace.add(10'000'000, [&](std::uint64_t) { return Center + noise.next(); });
+
+        const std::uint64_t holdStart = trace.getTime();
+        trace.add(10'000'000, [&](std::uint64_t) { return Center + 100 + noise.next(); });
+        const std::uint64_t holdEnd = trace.getTime();
+
+        pwswd::StickCalibrator calibrator("/dev/null");
+        std::int32_t centerBeforeHold = 0;
+        std::uint64_t stalls = 0;
+        replay(trace.finish(), calibrator, [&](std::uint64_t time, std::int32_t value) {
+            if (time + SampleInterval == holdStart)
+                centerBeforeHold = calibrator.getCenter(axis);
+            else if (time >= holdStart && time < holdEnd)
+                stalls += calibrator.getDisplacement(axis, value) == 0;
+        });
+
+        check(calibrator.getCalibration(axis).deadZone < 100 - 8, "dead zone is tight enough for the held position");
+        check(stalls == 0, "slow movement just past the dead zone keeps going, stalled " + std::to_string(stalls) + " times");
+        check(std::abs(calibrator.getCenter(axis) - centerBeforeHold) <= 2, "center stays put while the stick is held");
+    }
+
+    // Moving the stick slowly through the dead zone and back isn't resting either
+    {
+        TraceBuilder trace;
+        Noise noise(8);
+        trace.add(10'000'000, [&](std::uint64_t) { return Center + noise.next(); });
+        const std::uint64_t sweepStart = trace.getTime();
+        for (int sweep = 0; sweep < 10; sweep++) {
+            trace.add(1'000'000, [&](std::uint64_t elapsed) { return Center + std::int32_t(elapsed / 10'000) + noise.next(); });
+            trace.add(1'000'000, [&](std::uint64_t elapsed) { return Center + 100 - std::int32_t(elapsed / 10'000) + noise.next(); });
+        }
+
+        pwswd::StickCalibrator calibrator("/dev/null");
+        std::int32_t centerBeforeSweeps = 0;
+        replay(trace.finish(), calibrator, [&](std::uint64_t time, std::int32_t) {
+            if (time + SampleInterval == sweepStart)
+                centerBeforeSweeps = calibrator.getCenter(axis);
+        });
+
+        check(std::abs(calibrator.getCenter(axis) - centerBeforeSweeps) <= 4, "center stays put while the stick sweeps, moved from " + std::to_string(centerBeforeSweeps) + " to " + std::to_string(calibrator.getCenter(axis)));
+    }
+
+    return pwswd::test::result();
+}
\ No newline at end of file
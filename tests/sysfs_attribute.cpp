@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "test.hpp"
+#include "devices/fake_sysfs.hpp"
+#include "devices/sysfs_attribute.hpp"
+
+using pwswd::test::check;
+
+// What a process reading the attribute would see, including anything left past the end of the value
+[[nodiscard]] std::string readFile(const std::string &path) {
+    std::ifstream file(path);
+
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+int main() {
+    pwswd::dev::FakeSysfs sysfs;
+    sysfs.addAttribute("/backlight/brightness", "128\n");
+    const std::string path = sysfs.getRoot() + "/backlight/brightness";
+
+    pwswd::dev::SysfsAttribute attribute(path);
+
+    // Reads strip the newline the kernel appends and fill the cache
+    check(attribute.read() == "128", "read strips the trailing newline");
+    check(attribute.readInteger() == 128, "read as an integer");
+
+    // Every write starts at offset 0 and a shorter value doesn't leave anything of a longer one behind
+    check(attribute.write(255) && readFile(path) == "255", "write replaces the value");
+    check(attribute.write(7) && readFile(path) == "7", "a shorter value leaves no trailing bytes");
+    check(attribute.write("1000") && readFile(path) == "1000", "a longer value after a shorter one");
+    check(attribute.write(3) && readFile(path) == "3", "repeated writes keep going to offset 0");
+    check(attribute.getWriteCount() == 4, "every changed value is written once");
+
+    // Writing the cached value again doesn't reach the file
+    auto writes = attribute.getWriteCount();
+    check(attribute.write(3) && attribute.write("3"), "unchanged writes succeed");
+    check(attribute.getWriteCount() == writes, "unchanged writes are skipped");
+
+    // A value that was just read counts as cached too
+    pwswd::dev::SysfsAttribute other(path);
+    check(other.read() == "3" && other.write(3) && other.getWriteCount() == 0, "writing the value that was read is skipped");
+
+    // Staged values are only written on flush, once and with the last value
+    writes = attribute.getWriteCount();
+    for (std::int32_t value : { 10, 20, 30, 40 })
+        attribute.stage(value);
+
+    check(attribute.isStaged(), "values are staged");
+    check(readFile(path) == "3" && attribute.getWriteCount() == writes, "staging doesn't write");
+
+    check(attribute.flush() && readFile(path) == "40", "flush writes the last staged value");
+    check(attribute.getWriteCount() == writes + 1, "several staged values turn into a single write");
+    check(!attribute.isStaged(), "flush clears the staged value");
+
+    writes = attribute.getWriteCount();
+    check(attribute.flush() && attribute.getWriteCount() == writes, "flush without a staged value doesn't write");
+
+    // Staging the cached value costs nothing on flush
+    attribute.stage(40);
+    check(attribute.flush() && attribute.getWriteCount() == writes, "flushing an unchanged staged value is skipped");
+
+    // A direct write wins over anything staged before it
+    attribute.stage(50);
+    check(attribute.write(60) && !attribute.isStaged(), "write drops the staged value");
+    check(attribute.flush() && readFile(path) == "60", "the dropped value isn't written on the next flush");
+
+    return pwswd::test::result();
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace pwswd::test {
+
+    inline std::uint32_t failures = 0;
+
+    // Reports a failed expectation and keeps going, so a single run shows everything that's broken
+    inline void check(bool condition, const std::string &description) {
+        if (condition)
+            return;
+
+        std::cerr << "FAILED: " << description << std::endl;
+        failures++;
+    }
+
+    // Exit code for main, meson treats everything but zero as a failed test
+    [[nodiscard]] inline int result() {
+        if (failures > 0)
+            std::cerr << failures << " check(s) failed" << std::endl;
+
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+}
\ No newline at end of file